@@ -0,0 +1,204 @@
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <CodeExecutor/Builder.hpp>
+#include <CodeExecutor/CommonCompiler.hpp>
+#include <CodeExecutor/CommonLinker.hpp>
+#include <CodeExecutor/ElfLoader.hpp>
+#include <CodeExecutor/IoUring.hpp>
+#include <CodeExecutor/Process.hpp>
+#include <CodeExecutor/Workspace.hpp>
+
+// Runs process many times with chosen I/O
+// engine and returns average time of one run
+static double measure(CodeExecutor::Process::IoEngine engine,
+                      const std::string& input,
+                      int runs)
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < runs; ++i)
+    {
+        CodeExecutor::Process process("/bin/cat");
+
+        process.setIoEngine(engine);
+        process.setInputData(input);
+
+        if (process.start() != 0 ||
+            process.readStandardOutput().size() != input.size())
+        {
+            std::cerr << "Process failed" << std::endl;
+            return 0;
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::micro>(end - begin).count() / runs;
+}
+
+// Calls function many times and returns
+// average time of one call
+template<class F>
+static double measureCalls(const F& function, int calls)
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    int sum = 0;
+
+    for (int i = 0; i < calls; ++i)
+    {
+        sum = function(sum, i);
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    // Result is used, so loop isn't removed
+    if (sum == 1)
+    {
+        std::cout << sum << std::endl;
+    }
+
+    return std::chrono::duration<double, std::nano>(end - begin).count() / calls;
+}
+
+static void measureFunctions(int calls)
+{
+    CodeExecutor::Builder builder;
+
+    builder.setCompiler(std::make_shared<CodeExecutor::CommonCompiler>("/usr/bin/gcc"));
+    builder.setLinker(std::make_shared<CodeExecutor::CommonLinker>("/usr/bin/gcc"));
+
+    builder.addTarget(
+        CodeExecutor::Source::createFromSource(
+            "extern \"C\" int add(int a, int b) { return a + b; }"
+        )
+    );
+
+    auto library = builder.build();
+    auto function = library->resolveFunction<int(int, int)>("add");
+
+    if (!function)
+    {
+        std::cerr << "Build failed" << std::endl;
+        return;
+    }
+
+    auto pointer = function.pointer();
+    std::function<int(int, int)> erased(pointer);
+
+    std::cout << "Call: "
+              << "pointer " << measureCalls(pointer, calls) << " ns, "
+              << "Function " << measureCalls(function, calls) << " ns, "
+              << "std::function " << measureCalls(erased, calls) << " ns" << std::endl;
+}
+
+// Loads many copies of small library, all
+// of them stay loaded until the end
+static void measureLoading(int libraries)
+{
+    auto workspace = std::make_shared<CodeExecutor::Workspace>();
+
+    CodeExecutor::Builder builder;
+
+    // Builder passes it's storage to linker
+    builder.setCompiler(std::make_shared<CodeExecutor::CommonCompiler>("/usr/bin/gcc"));
+    builder.setLinker(std::make_shared<CodeExecutor::CommonLinker>("/usr/bin/gcc"));
+    builder.setStorage(workspace);
+
+    builder.addTarget(
+        CodeExecutor::Source::createFromSource(
+            "extern \"C\" { int counter = 0; }"
+            "extern \"C\" int kernel(int a, int b) { ++counter; return a * b + counter; }"
+        )
+    );
+
+    auto built = builder.build();
+
+    std::ifstream file(built->path(), std::ios::binary);
+
+    auto image = std::make_shared<const std::string>(
+        std::istreambuf_iterator<char>(file),
+        std::istreambuf_iterator<char>()
+    );
+
+    // Dynamic linker shares handle of same
+    // file, so every library gets own copy
+    std::vector<CodeExecutor::ArtifactPtr> copies;
+
+    for (int i = 0; i < libraries; ++i)
+    {
+        auto copy = workspace->create("copy.so");
+
+        std::ofstream(copy->path().string(), std::ios::binary) << *image;
+
+        copies.push_back(std::move(copy));
+    }
+
+    std::vector<CodeExecutor::LibraryPtr> loaded;
+    loaded.reserve(libraries);
+
+    auto begin = std::chrono::steady_clock::now();
+
+    for (auto&& copy : copies)
+    {
+        loaded.push_back(std::make_shared<CodeExecutor::Library>(copy));
+    }
+
+    auto middle = std::chrono::steady_clock::now();
+
+    auto loader = std::make_shared<CodeExecutor::ElfLoader>();
+
+    for (int i = 0; i < libraries; ++i)
+    {
+        loaded.push_back(loader->load(image));
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    for (auto&& library : loaded)
+    {
+        if (!library->isLoaded() || library->resolveFunction<int(int, int)>("kernel")(2, 3) != 7)
+        {
+            std::cerr << "Loading failed: " << library->errorString() << std::endl;
+            return;
+        }
+    }
+
+    std::cout << "Load of " << libraries << " libraries: "
+              << "dlopen " << std::chrono::duration<double, std::micro>(middle - begin).count() / libraries << " us, "
+              << "ElfLoader " << std::chrono::duration<double, std::micro>(end - middle).count() / libraries << " us"
+              << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    int runs = argc > 1 ? std::stoi(argv[1]) : 1000;
+
+    if (CodeExecutor::IoUring::local() == nullptr)
+    {
+        std::cout << "io_uring is not available, poll is measured twice" << std::endl;
+    }
+
+    for (std::size_t size : {0ul, 4096ul, 1ul << 20})
+    {
+        std::string input(size, 'a');
+
+        auto poll = measure(CodeExecutor::Process::IoEngine::Poll, input, runs);
+        auto uring = measure(CodeExecutor::Process::IoEngine::Uring, input, runs);
+
+        std::cout << "Input " << size << " bytes: "
+                  << "poll " << poll << " us, "
+                  << "io_uring " << uring << " us" << std::endl;
+    }
+
+    measureFunctions(runs * 100000);
+
+    measureLoading(runs);
+
+    return 0;
+}
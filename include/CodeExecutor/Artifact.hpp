@@ -0,0 +1,35 @@
+#pragma once
+
+#include <memory>
+#include "filesystem.hpp"
+
+namespace CodeExecutor
+{
+    class Artifact;
+
+    using ArtifactPtr = std::shared_ptr<Artifact>;
+
+    /**
+     * @brief Class, that describes file, produced
+     * by build, such as object or shared library.
+     * File exists while artifact exists.
+     */
+    class Artifact
+    {
+    public:
+
+        /**
+         * @brief Destructor.
+         */
+        virtual ~Artifact() = default;
+
+        /**
+         * @brief Method for getting path, that
+         * compiler or linker can write artifact to
+         * and that can be read back.
+         * @return Path to file.
+         */
+        virtual std::filesystem::path path() const = 0;
+    };
+}
+
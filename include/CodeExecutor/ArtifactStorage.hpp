@@ -0,0 +1,39 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include "Artifact.hpp"
+
+namespace CodeExecutor
+{
+    class ArtifactStorage;
+
+    using ArtifactStoragePtr = std::shared_ptr<ArtifactStorage>;
+
+    /**
+     * @brief Class, that describes place, where
+     * build artifacts are created. Implementations
+     * must be safe to call from several threads
+     * at once.
+     */
+    class ArtifactStorage
+    {
+    public:
+
+        /**
+         * @brief Destructor.
+         */
+        virtual ~ArtifactStorage() = default;
+
+        /**
+         * @brief Method for creating empty artifact.
+         * @param name Artifact name. It's a hint,
+         * different artifacts may have same name.
+         * @return Smart pointer to artifact.
+         * @throws std::runtime_error If artifact
+         * can't be created.
+         */
+        virtual ArtifactPtr create(const std::string& name) = 0;
+    };
+}
+
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <list>
+#include <thread>
+#include <unordered_map>
+#include "Builder.hpp"
+
+namespace CodeExecutor
+{
+    class BuildService;
+
+    using BuildServicePtr = std::shared_ptr<BuildService>;
+
+    /**
+     * @brief Class, that describes service, which
+     * runs builds of many builders with limited
+     * concurrency. Jobs with higher priority are
+     * started first. Among jobs with equal priority
+     * jobs, that took longer last time (by builder
+     * fingerprint), are started first. Jobs, that
+     * were not started before their deadline, fail
+     * as soon as deadline passes.
+     *
+     * Running jobs share compile slots, so there
+     * are no more compiler processes, than builds
+     * running at once, whatever builders jobs are.
+     */
+    class BuildService
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        /**
+         * @brief Constructor.
+         * @param concurrency Maximum number of builds
+         * and compiler processes, running at once. If
+         * it's 0, number of hardware threads will be used.
+         * @param memoryPerBuild Expected memory usage of
+         * one build in bytes. New build is not started
+         * while other builds are running and available
+         * memory, minus this value for every running
+         * build, is less, than this value.
+         * @param historySize Maximum number of remembered
+         * build durations. Least recently used ones
+         * are forgotten first.
+         */
+        explicit BuildService(unsigned int concurrency = 0,
+                              std::uint64_t memoryPerBuild = 512ull * 1024 * 1024,
+                              std::size_t historySize = 4096);
+
+        /**
+         * @brief Destructor. Waits for running builds,
+         * jobs that were not started fail.
+         */
+        ~BuildService();
+
+        BuildService(const BuildService&) = delete;
+        BuildService& operator=(const BuildService&) = delete;
+
+        /**
+         * @brief Method for submitting build job.
+         * Builder must not be changed until build
+         * is finished.
+         * @param builder Smart pointer to builder.
+         * @param priority Job priority. Higher is
+         * started earlier.
+         * @param deadline Time point, until which job
+         * have to be started.
+         * @return Future with built library or error.
+         */
+        std::future<LibraryPtr> submit(BuilderPtr builder,
+                                       int priority = 0,
+                                       Clock::time_point deadline = Clock::time_point::max());
+
+        /**
+         * @brief Method for getting maximum number
+         * of builds, running at once.
+         * @return Number of builds.
+         */
+        unsigned int concurrency() const;
+
+        /**
+         * @brief Method for getting number of jobs,
+         * that wait to be started.
+         * @return Number of jobs.
+         */
+        std::size_t pending() const;
+
+        /**
+         * @brief Method for getting expected build
+         * duration, based on past builds.
+         * @param fingerprint Builder fingerprint.
+         * @return Expected duration. Zero if there
+         * was no builds with this fingerprint.
+         */
+        Clock::duration expectedDuration(const std::string& fingerprint) const;
+
+        /**
+         * @brief Method for getting number of
+         * remembered build durations.
+         * @return Number of builder fingerprints.
+         */
+        std::size_t historySize() const;
+
+        /**
+         * @brief Method for forgetting past
+         * build durations.
+         */
+        void clearHistory();
+
+    private:
+
+        struct Job
+        {
+            BuilderPtr builder;
+            std::string fingerprint;
+            int priority;
+            Clock::duration expectedDuration;
+            Clock::time_point deadline;
+            std::uint64_t sequence;
+            std::shared_ptr<std::promise<LibraryPtr>> promise;
+        };
+
+        struct JobOrder
+        {
+            bool operator()(const Job& lhs, const Job& rhs) const;
+        };
+
+        // Binary heap, ordered by `JobOrder`. It's not
+        // `std::priority_queue`, because expired jobs
+        // are removed from the middle
+        using JobsQueue = std::vector<Job>;
+
+        // Most recently used duration is at the front
+        using HistoryContainer = std::list<std::pair<std::string, Clock::duration>>;
+
+        void run();
+
+        void expire();
+
+        bool canStart() const;
+
+        void record(const std::string& fingerprint, Clock::duration duration);
+
+        static std::uint64_t availableMemory();
+
+        CompileSlotsPtr m_compileSlots;
+
+        std::uint64_t m_memoryPerBuild;
+        std::size_t m_historySize;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_condition;
+        std::condition_variable m_deadlineCondition;
+        JobsQueue m_jobs;
+        std::uint64_t m_sequence;
+        unsigned int m_running;
+        bool m_stopping;
+
+        HistoryContainer m_history;
+        std::unordered_map<std::string, HistoryContainer::iterator> m_historyIndex;
+
+        std::vector<std::thread> m_threads;
+        std::thread m_deadlineThread;
+    };
+}
+
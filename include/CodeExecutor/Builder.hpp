@@ -1,8 +1,21 @@
 #pragma once
 
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include "ArtifactStorage.hpp"
+#include "CompileSlots.hpp"
 #include "Compiler.hpp"
 #include "Linker.hpp"
 #include "Library.hpp"
+#include "LibraryCache.hpp"
+#include "Executor.hpp"
+#include "TieredLibrary.hpp"
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+#include <coroutine>
+#define CODEEXECUTOR_HAS_COROUTINES
+#endif
 
 namespace CodeExecutor
 {
@@ -24,8 +37,17 @@ namespace CodeExecutor
         using TargetsContainer = std::vector<BuildTarget>;
 
     public:
+        using BuildCallback = std::function<void(LibraryPtr, std::exception_ptr)>;
+
+#ifdef CODEEXECUTOR_HAS_COROUTINES
+        class BuildAwaitable;
+#endif
+
         /**
-         * @brief Constructor.
+         * @brief Constructor. Creates own workspace
+         * for objects and libraries.
+         * @throws std::runtime_error If workspace
+         * can't be created.
          */
         Builder();
 
@@ -117,15 +139,241 @@ namespace CodeExecutor
          */
         std::filesystem::path getTargetObjectNameAt(const TargetsContainer::size_type&& i) const;
 
+        /**
+         * @brief Method for setting maximum number of
+         * targets, that will be compiled simultaneously.
+         * Linkage is performed after all targets are
+         * compiled.
+         * @param jobs Number of jobs. If it's 0, number
+         * of hardware threads will be used.
+         */
+        void setJobs(unsigned int jobs);
+
+        /**
+         * @brief Method for getting maximum number
+         * of simultaneous compilations.
+         * @return Number of jobs.
+         */
+        unsigned int jobs() const;
+
+        /**
+         * @brief Method for setting library cache.
+         * If it's set, libraries are built once for
+         * every builder fingerprint and are shared
+         * by builders with the same cache. Cache must
+         * not be shared by builders with different
+         * linkers.
+         * @param cache Smart pointer to library cache.
+         * `nullptr` disables caching.
+         */
+        void setLibraryCache(LibraryCachePtr cache);
+
+        /**
+         * @brief Method for getting library cache.
+         * @return Smart pointer to library cache.
+         */
+        LibraryCachePtr libraryCache() const;
+
+        /**
+         * @brief Method for getting fingerprint of
+         * current build. It's based on compiler identity,
+         * building context and targets content.
+         * If there is no compiler, std::runtime_error
+         * will be thrown.
+         * @return Hex SHA-256 fingerprint.
+         */
+        std::string fingerprint() const;
+
+        /**
+         * @brief Method for enabling incremental
+         * building. In this mode builder remembers
+         * objects of the last build and recompiles
+         * only targets, whose content or object name
+         * changed. Change of compiler identity or
+         * building context causes full rebuild.
+         * Disabling mode forgets remembered objects.
+         * @param incremental Is incremental building
+         * enabled.
+         */
+        void setIncremental(bool incremental);
+
+        /**
+         * @brief Method for checking is incremental
+         * building enabled.
+         * @return Is incremental building enabled.
+         */
+        bool isIncremental() const;
+
+        /**
+         * @brief Method for enabling unity (jumbo)
+         * building. In this mode targets are merged
+         * into translation units of up to
+         * `unityBatchSize()` targets, so common headers
+         * are parsed once per unit. Targets, that
+         * declare the same names at namespace scope,
+         * are placed into different units.
+         * @param unityBuild Is unity building enabled.
+         */
+        void setUnityBuild(bool unityBuild);
+
+        /**
+         * @brief Method for checking is unity
+         * building enabled.
+         * @return Is unity building enabled.
+         */
+        bool isUnityBuild() const;
+
+        /**
+         * @brief Method for setting maximum number
+         * of targets in one unity translation unit.
+         * @param batchSize Number of targets. 0 is
+         * treated as 1.
+         */
+        void setUnityBatchSize(std::size_t batchSize);
+
+        /**
+         * @brief Method for getting maximum number
+         * of targets in one unity translation unit.
+         * @return Number of targets.
+         */
+        std::size_t unityBatchSize() const;
+
+        /**
+         * @brief Method for getting object names
+         * of targets, that were compiled by the last
+         * build. In unity mode all targets of
+         * compiled units are listed.
+         * @return Container with object names.
+         */
+        std::vector<std::filesystem::path> rebuiltTargets() const;
+
         /**
          * @brief Method for building targeted sources.
          * If building was not successful. std::runtime_error
-         * will be thrown.
+         * will be thrown. If several targets failed, the first
+         * caught error is thrown.
          * @todo Make custom exception type with fail stage
          * @return Built library.
          */
         LibraryPtr build() const;
 
+        /**
+         * @brief Method for building targeted sources,
+         * every compilation of which takes slot. Slots
+         * limit compiler processes of several builds.
+         * @param slots Compile slots or nullptr.
+         * @return Built library.
+         */
+        LibraryPtr build(const CompileSlotsPtr& slots) const;
+
+        /**
+         * @brief Method for building targeted sources
+         * on executor. Builder must not be changed or
+         * destroyed until building is finished.
+         * @return Future with built library or
+         * building error.
+         */
+        std::future<LibraryPtr> buildAsync() const;
+
+        /**
+         * @brief Method for building targeted sources
+         * on executor. Builder must not be changed or
+         * destroyed until building is finished.
+         * @param callback Callback, that will be called
+         * on executor thread with built library or with
+         * building error.
+         */
+        void buildAsync(BuildCallback callback) const;
+
+#ifdef CODEEXECUTOR_HAS_COROUTINES
+        /**
+         * @brief Method for awaiting building from
+         * C++20 coroutine: `co_await builder.buildAwaitable()`.
+         * Coroutine is resumed on executor thread.
+         * Builder must not be changed or destroyed
+         * until building is finished.
+         * @return Awaitable object.
+         */
+        BuildAwaitable buildAwaitable() const;
+#endif
+
+        /**
+         * @brief Method for tiered building. Targets
+         * are built with fast compiler and `-O0` first,
+         * then rebuilt on executor with compiler and
+         * optimization flag. Functions, resolved from
+         * result, switch to optimized build when it's
+         * ready. If fast building was not successful,
+         * std::runtime_error will be thrown.
+         * @return Tiered library with fast build.
+         */
+        TieredLibraryPtr buildTiered() const;
+
+        /**
+         * @brief Method for setting compiler for the
+         * fast tier. It may be any compiler, that is
+         * able to compile targets, for example, `clang`.
+         * @param compiler Compiler. `nullptr` means
+         * compiler of builder.
+         */
+        void setFastCompiler(CompilerPtr compiler);
+
+        /**
+         * @brief Method for getting compiler for the
+         * fast tier.
+         * @return Smart pointer to compiler.
+         */
+        CompilerPtr fastCompiler() const;
+
+        /**
+         * @brief Method for setting compile flag
+         * for optimized tier. By default it's `-O2`.
+         * @param flag Flag.
+         */
+        void setOptimizationFlag(std::string flag);
+
+        /**
+         * @brief Method for getting compile flag
+         * for optimized tier.
+         * @return Flag.
+         */
+        std::string optimizationFlag() const;
+
+        /**
+         * @brief Method for setting executor, that
+         * runs asynchronous builds.
+         * @param executor Smart pointer to executor.
+         * `nullptr` means global executor.
+         */
+        void setExecutor(ExecutorPtr executor);
+
+        /**
+         * @brief Method for getting executor, that
+         * runs asynchronous builds.
+         * @return Smart pointer to executor.
+         */
+        ExecutorPtr executor() const;
+
+        /**
+         * @brief Method for setting storage, where
+         * objects are created. It's also passed to linker,
+         * so linked libraries are created there, unless
+         * linker has own storage. By default it's own
+         * `Workspace` of builder, so files are removed
+         * when objects are released. With `MemoryStorage`
+         * objects are kept in memory, without storage they
+         * are written to paths, equal to target object names.
+         * @param storage Storage.
+         */
+        void setStorage(ArtifactStoragePtr storage);
+
+        /**
+         * @brief Method for getting storage, where
+         * objects are created.
+         * @return Storage or nullptr.
+         */
+        ArtifactStoragePtr storage() const;
+
         /**
          * @brief Method for setting building context.
          * @param context Smart pointer to building context.
@@ -140,12 +388,171 @@ namespace CodeExecutor
         BuildingContextPtr buildingContext() const;
 
     private:
-        std::hash<std::string> m_hash;
+
+        // Content hash and object of built target
+        struct BuiltObject
+        {
+            std::string contentHash;
+            ObjectPtr object;
+        };
+
+        // Built objects by object names
+        using BuiltObjectsContainer = std::unordered_map<std::string, BuiltObject>;
+
+        // Object names of targets, merged into unit
+        using UnitMembersContainer = std::vector<std::vector<std::filesystem::path>>;
+
+        /**
+         * @brief Method for getting fingerprint of
+         * compiler identity and building context.
+         * @param context Building context.
+         * @return Hex SHA-256 fingerprint.
+         */
+        std::string contextFingerprint(const BuildingContextPtr& context) const;
+
+        /**
+         * @brief Method for getting building context,
+         * that is passed to compiler. If automatic
+         * precompiled header is enabled, it's a copy of
+         * context with detected precompiled header.
+         * @return Building context.
+         */
+        BuildingContextPtr effectiveContext() const;
+
+        /**
+         * @brief Method for finding `#include` lines,
+         * that all sources start with.
+         * @param sources Sources.
+         * @return Lines, joined into header content.
+         */
+        static std::string commonIncludePrefix(const std::vector<SourcePtr>& sources);
+
+        /**
+         * @brief Method for making builder, that
+         * builds one of tiers.
+         * @param compiler Compiler.
+         * @param flag Additional compile flag.
+         * @param suffix Suffix of object names.
+         * @return Smart pointer to builder.
+         */
+        BuilderPtr makeTierBuilder(CompilerPtr compiler,
+                                   const std::string& flag,
+                                   const std::string& suffix) const;
+
+        /**
+         * @brief Method for making compilation units
+         * from targets. Without unity building every
+         * target is a unit.
+         * @param units Compilation units.
+         * @param members Targets of every unit.
+         */
+        void makeUnits(TargetsContainer& units,
+                       UnitMembersContainer& members) const;
+
+        /**
+         * @brief Method for getting objects of all
+         * units. Only changed units are compiled
+         * in incremental mode.
+         * @param slots Compile slots or nullptr.
+         * @return Objects in units order.
+         */
+        std::vector<ObjectPtr> compileTargets(const CompileSlotsPtr& slots) const;
+
+        /**
+         * @brief Method for compiling units
+         * with up to `m_jobs` threads.
+         * @param units Compilation units.
+         * @param context Building context.
+         * @param indices Indices of units to compile.
+         * @param objects Objects in units order.
+         * @param slots Compile slots or nullptr.
+         */
+        void compile(const TargetsContainer& units,
+                     const BuildingContextPtr& context,
+                     const std::vector<TargetsContainer::size_type>& indices,
+                     std::vector<ObjectPtr>& objects,
+                     const CompileSlotsPtr& slots) const;
 
         CompilerPtr m_compiler;
         LinkerPtr m_linker;
 
         TargetsContainer m_targets;
         BuildingContextPtr m_context;
+
+        unsigned int m_jobs;
+
+        LibraryCachePtr m_libraryCache;
+
+        ExecutorPtr m_executor;
+
+        ArtifactStoragePtr m_storage;
+
+        CompilerPtr m_fastCompiler;
+        std::string m_optimizationFlag;
+
+        bool m_incremental;
+
+        bool m_unityBuild;
+        std::size_t m_unityBatchSize;
+
+        mutable std::mutex m_stateMutex;
+        mutable BuiltObjectsContainer m_builtObjects;
+        mutable std::string m_builtContext;
+        mutable std::vector<std::filesystem::path> m_rebuiltTargets;
     };
+
+#ifdef CODEEXECUTOR_HAS_COROUTINES
+    /**
+     * @brief Class, that describes awaitable
+     * asynchronous build.
+     */
+    class Builder::BuildAwaitable
+    {
+    public:
+        explicit BuildAwaitable(const Builder* builder) :
+            m_builder(builder),
+            m_library(),
+            m_error()
+        {}
+
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            m_builder->buildAsync(
+                [this, handle](LibraryPtr library, std::exception_ptr error)
+                {
+                    m_library = std::move(library);
+                    m_error = std::move(error);
+
+                    handle.resume();
+                }
+            );
+        }
+
+        LibraryPtr await_resume()
+        {
+            if (m_error)
+            {
+                std::rethrow_exception(m_error);
+            }
+
+            return std::move(m_library);
+        }
+
+    private:
+        const Builder* m_builder;
+
+        LibraryPtr m_library;
+        std::exception_ptr m_error;
+    };
+
+    inline Builder::BuildAwaitable Builder::buildAwaitable() const
+    {
+        return BuildAwaitable(this);
+    }
+#endif
 }
@@ -19,6 +19,7 @@ namespace CodeExecutor
      * - Libraries to link
      * - Compiler flags
      * - Defines
+     * - Precompiled header
      */
     class BuildingContext
     {
@@ -27,6 +28,7 @@ namespace CodeExecutor
         using LibrariesContainer = std::vector<std::string>;
         using CompileFlagsContainer = std::vector<std::string>;
         using DefinesContainer = std::vector<std::string>;
+        using ArgumentsContainer = std::vector<std::string>;
 
     public:
 
@@ -285,6 +287,58 @@ namespace CodeExecutor
          */
         DefinesContainer::value_type defineAt(const DefinesContainer::size_type&& index) const;
 
+        /**
+         * @brief Method for getting context, flattened
+         * to `gcc`/`clang` compiler arguments. Include
+         * directories, library directories, libraries,
+         * defines and compile flags are placed in this
+         * order.
+         * @return Compiler arguments.
+         */
+        ArgumentsContainer compileArguments() const;
+
+        /**
+         * @brief Method for setting content of header,
+         * that will be precompiled once and included
+         * before every compiled source.
+         * @param content Header content. Empty string
+         * disables precompiled header.
+         */
+        void setPrecompiledHeader(std::string content);
+
+        /**
+         * @brief Method for getting content of
+         * precompiled header.
+         * @return Header content.
+         */
+        const std::string& precompiledHeader() const;
+
+        /**
+         * @brief Method for enabling automatic
+         * precompiled header. In this mode builder
+         * precompiles `#include` directives, that all
+         * targets start with, if no header is set
+         * explicitly.
+         * @param automatic Is automatic precompiled
+         * header enabled.
+         */
+        void setAutomaticPrecompiledHeader(bool automatic);
+
+        /**
+         * @brief Method for checking is automatic
+         * precompiled header enabled.
+         * @return Is automatic precompiled header enabled.
+         */
+        bool isAutomaticPrecompiledHeader() const;
+
+        /**
+         * @brief Method for getting fingerprint of
+         * everything, that affects compilation result:
+         * compiler arguments and precompiled header.
+         * @return Hex SHA-256 fingerprint.
+         */
+        std::string fingerprint() const;
+
     private:
 
         IncludeDirectoriesContainer m_includeDirectories{};
@@ -293,6 +347,9 @@ namespace CodeExecutor
         CompileFlagsContainer m_compileFlags{};
         DefinesContainer m_defines{};
 
+        std::string m_precompiledHeader{};
+        bool m_automaticPrecompiledHeader = false;
+
     };
 }
 
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include "Compiler.hpp"
+
+namespace CodeExecutor
+{
+    class CachingCompiler;
+
+    using CachingCompilerPtr = std::shared_ptr<CachingCompiler>;
+
+    /**
+     * @brief Compiler decorator, that stores
+     * compiled objects in persistent on disk
+     * cache. Objects are keyed by SHA-256 of
+     * source content, flattened building context
+     * and compiler identity. Cache directory may
+     * be reused by later runs. If cache size
+     * exceeds budget, least recently used objects
+     * are removed.
+     *
+     * Objects taken from cache have no compiler
+     * diagnostics.
+     */
+    class CachingCompiler : public Compiler
+    {
+    public:
+
+        /**
+         * @brief Constructor. Cache directory will
+         * be created if it does not exist, existing
+         * objects are loaded into cache index.
+         * @param compiler Compiler, that performs
+         * actual compilation.
+         * @param directory Path to cache directory.
+         * @param sizeBudget Maximum cache size in bytes.
+         */
+        CachingCompiler(CompilerPtr compiler,
+                        std::filesystem::path directory,
+                        std::uintmax_t sizeBudget);
+
+        /**
+         * @copydoc Compiler::compile
+         */
+        ObjectPtr compile(SourcePtr source,
+                          const std::filesystem::path& output,
+                          BuildingContextPtr buildingContext) override;
+
+        /**
+         * @copydoc Compiler::identity
+         */
+        std::string identity() const override;
+
+        /**
+         * @brief Method for getting decorated
+         * compiler.
+         * @return Smart pointer to compiler.
+         */
+        CompilerPtr compiler() const;
+
+        /**
+         * @brief Method for getting cache directory.
+         * @return Path to cache directory.
+         */
+        std::filesystem::path directory() const;
+
+        /**
+         * @brief Method for getting cache size budget.
+         * @return Size budget in bytes.
+         */
+        std::uintmax_t sizeBudget() const;
+
+        /**
+         * @brief Method for getting current size
+         * of cached objects.
+         * @return Size in bytes.
+         */
+        std::uintmax_t size() const;
+
+        /**
+         * @brief Method for getting number of
+         * compilations, served from cache.
+         * @return Number of hits.
+         */
+        std::uint64_t hits() const;
+
+        /**
+         * @brief Method for getting number of
+         * compilations, performed by decorated
+         * compiler.
+         * @return Number of misses.
+         */
+        std::uint64_t misses() const;
+
+        /**
+         * @brief Method for building cache key.
+         * @param source Source object.
+         * @param buildingContext Building context.
+         * @return Hex SHA-256 key.
+         */
+        std::string key(const SourcePtr& source,
+                        const BuildingContextPtr& buildingContext) const;
+
+    private:
+
+        struct Entry
+        {
+            std::string key;
+            std::uintmax_t size;
+        };
+
+        // Most recently used entry is at the front
+        using EntriesContainer = std::list<Entry>;
+
+        void loadIndex();
+
+        std::filesystem::path entryPath(const std::string& key) const;
+
+        bool restore(const std::string& key, const std::filesystem::path& output);
+
+        void store(const std::string& key, const std::filesystem::path& object);
+
+        void evict();
+
+        CompilerPtr m_compiler;
+        std::filesystem::path m_directory;
+        std::uintmax_t m_sizeBudget;
+
+        mutable std::mutex m_mutex;
+        EntriesContainer m_entries;
+        std::unordered_map<std::string, EntriesContainer::iterator> m_index;
+        std::uintmax_t m_size;
+
+        std::atomic<std::uint64_t> m_hits;
+        std::atomic<std::uint64_t> m_misses;
+    };
+}
+
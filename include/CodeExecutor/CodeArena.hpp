@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace CodeExecutor
+{
+    class CodeArena;
+
+    using CodeArenaPtr = std::shared_ptr<CodeArena>;
+
+    /**
+     * @brief Class, that describes reserved range
+     * of address space, that loaded code is placed
+     * into. Memory is committed by allocation and
+     * returned to system on release. Arena is
+     * thread safe.
+     */
+    class CodeArena
+    {
+    public:
+
+        /**
+         * @brief Constructor. Reserves address
+         * space without committing memory.
+         * @param size Arena size in bytes.
+         * @throws std::runtime_error If address
+         * space can't be reserved.
+         */
+        explicit CodeArena(std::size_t size);
+
+        /**
+         * @brief Destructor. Unmaps arena, all
+         * allocations must be released.
+         */
+        ~CodeArena();
+
+        CodeArena(const CodeArena&) = delete;
+        CodeArena& operator=(const CodeArena&) = delete;
+
+        /**
+         * @brief Method for allocating block. It's
+         * zeroed and readable and writable.
+         * @param size Block size.
+         * @param alignment Block alignment, power
+         * of two. Blocks are page aligned anyway.
+         * @return Pointer to block or nullptr if
+         * arena is exhausted.
+         */
+        void* allocate(std::size_t size, std::size_t alignment = 0);
+
+        /**
+         * @brief Method for releasing block.
+         * @param block Pointer, returned by `allocate`.
+         * @param size Block size.
+         */
+        void release(void* block, std::size_t size);
+
+        /**
+         * @brief Method for getting arena size.
+         * @return Size in bytes.
+         */
+        std::size_t size() const;
+
+        /**
+         * @brief Method for getting size of
+         * allocated blocks.
+         * @return Size in bytes.
+         */
+        std::size_t used() const;
+
+        /**
+         * @brief Method for getting system
+         * page size.
+         * @return Size in bytes.
+         */
+        static std::size_t pageSize();
+
+    private:
+        char* m_base;
+        std::size_t m_size;
+
+        mutable std::mutex m_mutex;
+
+        // Offset to size of free ranges
+        std::map<std::size_t, std::size_t> m_free;
+        std::size_t m_used;
+    };
+}
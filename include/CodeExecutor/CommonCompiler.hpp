@@ -1,12 +1,19 @@
 #pragma once
 
+#include <future>
+#include <mutex>
+#include <unordered_map>
 #include "Compiler.hpp"
 #include "Process.hpp"
 
 namespace CodeExecutor
 {
     /**
-     * @brief Common compiler wrapper.
+     * @brief Common compiler wrapper. Precompiled
+     * headers of building context are built once
+     * for every compiler identity, arguments and
+     * header content and are stored in precompiled
+     * headers directory.
      */
     class CommonCompiler : public Compiler
     {
@@ -25,7 +32,56 @@ namespace CodeExecutor
                                         const std::filesystem::path& output,
                                         CodeExecutor::BuildingContextPtr buildingContext) override;
 
+        /**
+         * @copydoc Compiler::identity
+         */
+        std::string identity() const override;
+
+        /**
+         * @brief Method for setting directory, where
+         * precompiled headers are stored. By default
+         * it's `CodeExecutorPCH` in temporary directory.
+         * @param path Path to directory.
+         */
+        void setPrecompiledHeadersDirectory(std::filesystem::path path);
+
+        /**
+         * @brief Method for getting directory, where
+         * precompiled headers are stored.
+         * @return Path to directory.
+         */
+        std::filesystem::path precompiledHeadersDirectory() const;
+
     private:
+
+        /**
+         * @brief Method for getting path to header,
+         * that has to be included to use precompiled
+         * header. Header is precompiled if it's not
+         * yet. If precompilation failed,
+         * std::runtime_error will be thrown.
+         * @param buildingContext Building context
+         * with precompiled header.
+         * @param arguments Compiler arguments.
+         * @return Path to header.
+         */
+        std::filesystem::path precompiledHeader(const BuildingContextPtr& buildingContext,
+                                                const Process::ArgumentsContainer& arguments);
+
+        /**
+         * @brief Method for precompiling header.
+         * @param content Header content.
+         * @param directory Directory for header.
+         * @param arguments Compiler arguments.
+         */
+        void precompile(const std::string& content,
+                        const std::filesystem::path& directory,
+                        const Process::ArgumentsContainer& arguments);
+
         std::filesystem::path m_path;
+
+        mutable std::mutex m_mutex;
+        std::filesystem::path m_headersDirectory;
+        std::unordered_map<std::string, std::shared_future<void>> m_headers;
     };
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "ArtifactStorage.hpp"
+#include "ElfLoader.hpp"
 #include "Linker.hpp"
 #include "Process.hpp"
 
@@ -20,13 +22,52 @@ namespace CodeExecutor
         explicit CommonLinker(std::filesystem::path path);
 
         /**
-         * @copydoc Linker::link
+         * @copydoc Linker::link(const std::vector<ObjectPtr>&)
          */
         LibraryPtr link(const std::vector<ObjectPtr>& objects) override;
 
+        /**
+         * @copydoc Linker::link(const std::vector<ObjectPtr>&, const ArtifactStoragePtr&)
+         */
+        LibraryPtr link(const std::vector<ObjectPtr>& objects,
+                        const ArtifactStoragePtr& storage) override;
+
+        /**
+         * @brief Method for setting storage, where
+         * linked libraries are created. By default
+         * storage of builder is used, and without
+         * it they are written to current directory.
+         * With `Workspace` they are removed, when
+         * library is released.
+         * @param storage Storage.
+         */
+        void setStorage(ArtifactStoragePtr storage);
+
+        /**
+         * @brief Method for getting storage, where
+         * linked libraries are created.
+         * @return Storage or nullptr.
+         */
+        ArtifactStoragePtr storage() const;
+
+        /**
+         * @brief Method for setting loader, that
+         * loads linked libraries instead of `dlopen`.
+         * Library file can be removed after linkage.
+         * @param loader Loader or nullptr.
+         */
+        void setLoader(ElfLoaderPtr loader);
+
+        /**
+         * @brief Method for getting loader.
+         * @return Loader or nullptr.
+         */
+        ElfLoaderPtr loader() const;
+
     private:
         std::filesystem::path m_path;
-        int m_counter = 0;
+        ArtifactStoragePtr m_storage;
+        ElfLoaderPtr m_loader;
     };
 }
 
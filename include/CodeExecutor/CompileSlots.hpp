@@ -0,0 +1,62 @@
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+namespace CodeExecutor
+{
+    class CompileSlots;
+
+    using CompileSlotsPtr = std::shared_ptr<CompileSlots>;
+
+    /**
+     * @brief Class, that describes limit of
+     * compiler processes, shared by builds. Every
+     * compilation takes slot for it's duration.
+     */
+    class CompileSlots
+    {
+    public:
+
+        /**
+         * @brief Constructor.
+         * @param slots Number of slots. If it's 0,
+         * number of hardware threads will be used.
+         */
+        explicit CompileSlots(unsigned int slots = 0);
+
+        CompileSlots(const CompileSlots&) = delete;
+        CompileSlots& operator=(const CompileSlots&) = delete;
+
+        /**
+         * @brief Method for taking slot. It waits
+         * until some slot is released.
+         */
+        void acquire();
+
+        /**
+         * @brief Method for releasing taken slot.
+         */
+        void release();
+
+        /**
+         * @brief Method for getting number of slots.
+         * @return Number of slots.
+         */
+        unsigned int capacity() const;
+
+        /**
+         * @brief Method for getting number of
+         * taken slots.
+         * @return Number of slots.
+         */
+        unsigned int taken() const;
+
+    private:
+        mutable std::mutex m_mutex;
+        std::condition_variable m_condition;
+        unsigned int m_capacity;
+        unsigned int m_taken;
+    };
+}
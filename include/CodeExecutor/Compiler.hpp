@@ -13,7 +13,10 @@ namespace CodeExecutor
 
     /**
      * @brief Class, that describes
-     * code compiler.
+     * code compiler. Implementations must
+     * be safe to call from several threads
+     * at once, because builder may compile
+     * targets in parallel.
      */
     class Compiler
     {
@@ -27,38 +30,24 @@ namespace CodeExecutor
         /**
          * @brief Method, that used by builder
          * @param source Smart pointer to source object.
+         * @param output Path to result object file.
          * @param buildingContext Building context.
-         * @return Smart pointer to object
+         * @return Smart pointer to object. Compiler
+         * diagnostics are stored inside of it.
          */
         virtual ObjectPtr compile(SourcePtr source,
                                   const std::filesystem::path& output,
                                   BuildingContextPtr buildingContext) = 0;
 
         /**
-         * @brief Method for getting standard output
-         * string.
-         * @return Standard output.
+         * @brief Method for getting string, that
+         * identifies compiler binary and it's
+         * configuration. Different compilers must
+         * return different identities, because
+         * it's used as a part of caching keys.
+         * @return Identity string.
          */
-        const std::string& standardOutput() const;
-
-        /**
-         * @brief Method for getting standard error
-         * string.
-         * @return Standard error.
-         */
-        const std::string& standardError() const;
-
-    protected:
-
-        void setOutput(std::string output);
-
-        void setError(std::string error);
-
-    private:
-
-        std::string m_stdout;
-        std::string m_stderr;
-
+        virtual std::string identity() const;
     };
 }
 
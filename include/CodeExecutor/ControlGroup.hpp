@@ -0,0 +1,104 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <sys/types.h>
+#include "filesystem.hpp"
+
+namespace CodeExecutor
+{
+    class ControlGroup;
+
+    using ControlGroupPtr = std::shared_ptr<ControlGroup>;
+
+    /**
+     * @brief Class, that describes cgroup v2 leaf,
+     * that limits resources of processes, placed
+     * into it. Parent group has to be delegated to
+     * current user and have `cpu` and `memory`
+     * controllers available.
+     */
+    class ControlGroup
+    {
+    public:
+
+        /**
+         * @brief Constructor. Creates group
+         * directory, if it doesn't exist, and enables
+         * `cpu` and `memory` controllers in parent.
+         * @param path Path to group directory inside
+         * of cgroup v2 hierarchy.
+         * @throws std::runtime_error If group
+         * can't be created.
+         */
+        explicit ControlGroup(std::filesystem::path path);
+
+        /**
+         * @brief Destructor. Removes group, if it
+         * was created by constructor and has
+         * no processes.
+         */
+        ~ControlGroup();
+
+        ControlGroup(const ControlGroup&) = delete;
+        ControlGroup& operator=(const ControlGroup&) = delete;
+
+        /**
+         * @brief Method for getting group path.
+         * @return Path to group directory.
+         */
+        std::filesystem::path path() const;
+
+        /**
+         * @brief Method for getting path to file, that
+         * moves process into group, when it's id
+         * is written to it.
+         * @return Path to `cgroup.procs`.
+         */
+        std::filesystem::path processesFile() const;
+
+        /**
+         * @brief Method for limiting CPU bandwidth
+         * of group (`cpu.max`).
+         * @param cpus Number of CPUs, that group can
+         * fully use. 0 removes limit.
+         * @param period Accounting period.
+         * @throws std::runtime_error If limit
+         * can't be set.
+         */
+        void setCpuLimit(double cpus,
+                         std::chrono::microseconds period = std::chrono::microseconds(100000));
+
+        /**
+         * @brief Method for limiting memory of
+         * group (`memory.max`). Processes, that
+         * exceed it, are killed by OOM killer.
+         * @param bytes Limit. 0 removes limit.
+         * @throws std::runtime_error If limit
+         * can't be set.
+         */
+        void setMemoryLimit(std::size_t bytes);
+
+        /**
+         * @brief Method for moving process into group.
+         * @param pid Process id.
+         * @return Was process moved.
+         */
+        bool attach(pid_t pid) const;
+
+        /**
+         * @brief Method for getting cgroup v2
+         * directory of current process.
+         * @return Path to directory or empty path,
+         * if cgroup v2 is not mounted.
+         */
+        static std::filesystem::path current();
+
+    private:
+
+        void writeFile(const std::string& name, const std::string& value) const;
+
+        std::filesystem::path m_path;
+        bool m_created;
+    };
+}
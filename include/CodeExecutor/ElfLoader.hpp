@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include "CodeArena.hpp"
+#include "Library.hpp"
+
+namespace CodeExecutor
+{
+    class ElfLoader;
+
+    using ElfLoaderPtr = std::shared_ptr<ElfLoader>;
+
+    /**
+     * @brief Class, that describes loader of
+     * x86-64 shared objects, that is used instead
+     * of `dlopen`. Objects are mapped from memory
+     * into one code arena and aren't registered in
+     * dynamic linker. Undefined symbols are resolved
+     * against fixed import set: added imports and
+     * symbols, that are already loaded into process
+     * (libc, libstdc++ and exported host symbols).
+     * Dependencies aren't loaded and thread local
+     * storage isn't supported. Loader must be owned
+     * by smart pointer, libraries keep it alive.
+     */
+    class ElfLoader : public std::enable_shared_from_this<ElfLoader>
+    {
+    public:
+
+        /**
+         * @brief Constructor.
+         * @param arenaSize Size of address space,
+         * reserved for loaded code.
+         * @throws std::runtime_error If arena
+         * can't be reserved.
+         */
+        explicit ElfLoader(std::size_t arenaSize = std::size_t(1) << 30);
+
+        ElfLoader(const ElfLoader&) = delete;
+        ElfLoader& operator=(const ElfLoader&) = delete;
+
+        /**
+         * @brief Method for adding import. It's
+         * preferred over symbols of process.
+         * @param name Symbol name.
+         * @param address Symbol address.
+         */
+        void addImport(const std::string& name, void* address);
+
+        /**
+         * @brief Method for finding import.
+         * @param name Symbol name.
+         * @return Symbol address or nullptr.
+         */
+        void* import(const char* name) const;
+
+        /**
+         * @brief Method for loading shared object
+         * from memory. If loading fails, library is
+         * not loaded and has error string.
+         * @param image Shared object content.
+         * @param path Path, reported by library.
+         * @return Smart pointer to library.
+         */
+        LibraryPtr load(std::shared_ptr<const std::string> image,
+                        std::filesystem::path path = std::filesystem::path());
+
+        /**
+         * @brief Method for loading shared object
+         * from file. File is read once, so it can be
+         * removed after loading.
+         * @param path Path to shared object.
+         * @return Smart pointer to library.
+         */
+        LibraryPtr load(const std::filesystem::path& path);
+
+        /**
+         * @brief Method for getting arena, that
+         * libraries are mapped into.
+         * @return Smart pointer to arena.
+         */
+        CodeArenaPtr arena() const;
+
+    private:
+
+        /**
+         * @brief Class, that describes library,
+         * loaded by loader.
+         */
+        class Module;
+
+        CodeArenaPtr m_arena;
+
+        mutable std::shared_mutex m_importsMutex;
+
+        // Missing symbols are cached too
+        mutable std::unordered_map<std::string, void*> m_imports;
+    };
+}
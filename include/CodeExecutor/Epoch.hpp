@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace CodeExecutor
+{
+    /**
+     * @brief Class, that describes process wide
+     * epoch based reclamation. Readers mark critical
+     * sections with `Guard` and never block. Objects,
+     * retired by writers, are destroyed only after
+     * every reader, that could see them, has left
+     * its critical section.
+     */
+    class Epoch
+    {
+    public:
+
+        /**
+         * @brief Class, that describes reader
+         * critical section. Guards can be nested.
+         */
+        class Guard
+        {
+        public:
+
+            /**
+             * @brief Constructor. Enters
+             * critical section.
+             */
+            Guard();
+
+            /**
+             * @brief Destructor. Leaves
+             * critical section.
+             */
+            ~Guard();
+
+            Guard(const Guard&) = delete;
+            Guard& operator=(const Guard&) = delete;
+        };
+
+        /**
+         * @brief Method for retiring object. It's
+         * destroyed by `reclaim` or `synchronize`
+         * after grace period. Object must already be
+         * unreachable for new readers.
+         * @param object Object.
+         */
+        static void retire(std::shared_ptr<void> object);
+
+        /**
+         * @brief Method for destroying retired
+         * objects, whose grace period is over.
+         * It doesn't wait for readers.
+         * @return Number of destroyed objects.
+         */
+        static std::size_t reclaim();
+
+        /**
+         * @brief Method for waiting until all
+         * readers, that are in critical sections
+         * now, leave them, and destroying all
+         * retired objects. It must not be called
+         * inside of critical section.
+         */
+        static void synchronize();
+
+        /**
+         * @brief Method for getting number of
+         * retired and not yet destroyed objects.
+         * @return Number of objects.
+         */
+        static std::size_t retired();
+    };
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace CodeExecutor
+{
+    class Executor;
+
+    using ExecutorPtr = std::shared_ptr<Executor>;
+
+    /**
+     * @brief Class, that describes pool of
+     * threads, that run library work such as
+     * asynchronous builds. Tasks are executed
+     * in FIFO order.
+     */
+    class Executor
+    {
+    public:
+        using Task = std::function<void()>;
+
+        /**
+         * @brief Constructor.
+         * @param threads Number of threads. If it's 0,
+         * number of hardware threads will be used.
+         */
+        explicit Executor(unsigned int threads = 0);
+
+        /**
+         * @brief Destructor. Waits for all posted
+         * tasks to be executed.
+         */
+        ~Executor();
+
+        Executor(const Executor&) = delete;
+        Executor& operator=(const Executor&) = delete;
+
+        /**
+         * @brief Method for posting task to
+         * be executed by one of the threads.
+         * Exceptions, thrown by task, are ignored.
+         * @param task Task.
+         */
+        void post(Task task);
+
+        /**
+         * @brief Method for getting number of
+         * threads.
+         * @return Number of threads.
+         */
+        unsigned int threads() const;
+
+        /**
+         * @brief Method for getting process wide
+         * executor, that is used by default.
+         * @return Smart pointer to executor.
+         */
+        static ExecutorPtr global();
+
+    private:
+
+        void run();
+
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        std::deque<Task> m_tasks;
+        bool m_stopping;
+
+        std::vector<std::thread> m_threads;
+    };
+}
+
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include "filesystem.hpp"
+
+namespace CodeExecutor
+{
+    class ForkServer;
+
+    using ForkServerPtr = std::shared_ptr<ForkServer>;
+
+    /**
+     * @brief Class, that describes fork server
+     * (zygote). It's a small helper process, that
+     * spawns children instead of the host process.
+     * Host process sends program, arguments and
+     * standard descriptors over Unix socket, so
+     * spawning cost doesn't depend on host process
+     * size. Fork server has to be created early,
+     * while host process is small.
+     */
+    class ForkServer
+    {
+        struct HideArg{};
+    public:
+        using ArgumentsContainer = std::vector<std::string>;
+
+        /**
+         * @brief Hidden constructor.
+         * @param socket Control socket.
+         * @param pid Fork server process id.
+         */
+        ForkServer(int socket, pid_t pid, HideArg);
+
+        /**
+         * @brief Destructor. Stops fork server.
+         * Already spawned children are not affected.
+         */
+        ~ForkServer();
+
+        ForkServer(const ForkServer&) = delete;
+        ForkServer& operator=(const ForkServer&) = delete;
+
+        /**
+         * @brief Method for starting fork server
+         * process. If it can't be started,
+         * std::runtime_error will be thrown.
+         * @return Smart pointer to fork server.
+         */
+        static ForkServerPtr create();
+
+        /**
+         * @brief Method for setting process wide
+         * fork server, that is used by processes
+         * without own fork server.
+         * @param server Fork server. `nullptr`
+         * means processes are forked by host.
+         */
+        static void setGlobal(ForkServerPtr server);
+
+        /**
+         * @brief Method for getting process wide
+         * fork server.
+         * @return Fork server or `nullptr`.
+         */
+        static ForkServerPtr global();
+
+        /**
+         * @brief Method for getting fork server
+         * process id.
+         * @return Process id.
+         */
+        pid_t pid() const;
+
+        /**
+         * @brief Method for spawning child process.
+         * Descriptors are duplicated into child as
+         * stdin, stdout and stderr. They can be
+         * closed by caller after this call.
+         * @param program Path to program.
+         * @param arguments Program arguments.
+         * @param workingDirectory Child working directory.
+         * @param stdinFd Child stdin descriptor.
+         * @param stdoutFd Child stdout descriptor.
+         * @param stderrFd Child stderr descriptor.
+         * @param processesFile Path to `cgroup.procs` of
+         * control group, that child joins before program
+         * is executed. Empty path means no group.
+         * @return Descriptor, that have to be passed
+         * to `wait`, or -1 if request can't be sent.
+         */
+        int spawn(const std::filesystem::path& program,
+                  const ArgumentsContainer& arguments,
+                  const std::filesystem::path& workingDirectory,
+                  int stdinFd,
+                  int stdoutFd,
+                  int stderrFd,
+                  const std::filesystem::path& processesFile = std::filesystem::path());
+
+        /**
+         * @brief Method for waiting spawned child
+         * to end. Descriptor is closed.
+         * @param handle Descriptor, returned by `spawn`.
+         * @param usage Resources, used by child.
+         * May be nullptr.
+         * @return Child wait status (as `waitpid` one)
+         * or -1 if it's unknown.
+         */
+        static int wait(int handle, rusage* usage = nullptr);
+
+        /**
+         * @brief Structure, that is written to
+         * handle, when child ends.
+         */
+        struct Reply
+        {
+            int status;
+            rusage usage;
+        };
+
+    private:
+
+        /**
+         * @brief Fork server process main loop.
+         * @param socket Control socket.
+         */
+        [[noreturn]] static void serve(int socket);
+
+        int m_socket;
+        pid_t m_pid;
+
+        static std::mutex m_globalMutex;
+        static ForkServerPtr m_global;
+    };
+}
+
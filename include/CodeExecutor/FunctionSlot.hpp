@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include "Epoch.hpp"
+#include "Library.hpp"
+
+namespace CodeExecutor
+{
+    template<class M>
+    class FunctionSlot;
+
+    /**
+     * @brief Class, that describes named function,
+     * whose implementation can be replaced while it's
+     * called. Calls load pointer without waiting and
+     * run inside of `Epoch::Guard`, so replaced library
+     * is unloaded only after all calls to it return.
+     */
+    template<class R, class... Args>
+    class FunctionSlot<R(Args...)>
+    {
+    public:
+        using Pointer = R(*)(Args...);
+
+        /**
+         * @brief Constructor. Creates
+         * empty slot.
+         * @param name Function name.
+         */
+        explicit FunctionSlot(std::string name) :
+            m_name(std::move(name)),
+            m_pointer(nullptr),
+            m_mutex(),
+            m_library()
+        {}
+
+        /**
+         * @brief Destructor. Library is retired,
+         * slot must not be called anymore.
+         */
+        ~FunctionSlot()
+        {
+            Epoch::retire(std::move(m_library));
+        }
+
+        FunctionSlot(const FunctionSlot&) = delete;
+        FunctionSlot& operator=(const FunctionSlot&) = delete;
+
+        /**
+         * @brief Method for switching slot to
+         * function of library. Previous library is
+         * retired and destroyed after grace period.
+         * @param library Loaded library.
+         * @return Is function found in library. If
+         * it's not, slot is not changed.
+         */
+        bool publish(LibraryPtr library)
+        {
+            auto pointer = reinterpret_cast<Pointer>(
+                library ? library->resolve(m_name.c_str()) : nullptr
+            );
+
+            if (pointer == nullptr)
+            {
+                return false;
+            }
+
+            LibraryPtr previous;
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                previous = std::move(m_library);
+                m_library = std::move(library);
+
+                m_pointer.store(pointer, std::memory_order_seq_cst);
+            }
+
+            Epoch::retire(std::move(previous));
+            Epoch::reclaim();
+
+            return true;
+        }
+
+        /**
+         * @brief Method for calling current
+         * function. Slot must not be empty.
+         */
+        R operator()(Args... args) const
+        {
+            Epoch::Guard guard;
+
+            auto function = m_pointer.load(std::memory_order_acquire);
+
+            return function(std::forward<Args>(args)...);
+        }
+
+        /**
+         * @brief Method for getting function name.
+         * @return Name.
+         */
+        const std::string& name() const
+        {
+            return m_name;
+        }
+
+        /**
+         * @brief Method for getting library,
+         * that defines current function.
+         * @return Smart pointer to library
+         * or nullptr.
+         */
+        LibraryPtr library() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            return m_library;
+        }
+
+        explicit operator bool() const
+        {
+            return m_pointer.load(std::memory_order_acquire) != nullptr;
+        }
+
+    private:
+        std::string m_name;
+        std::atomic<Pointer> m_pointer;
+
+        // Publishers are serialized, so previous
+        // library is always retired after swap
+        mutable std::mutex m_mutex;
+        LibraryPtr m_library;
+    };
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <linux/io_uring.h>
+
+namespace CodeExecutor
+{
+    /**
+     * @brief Class, that describes minimal io_uring
+     * instance, used for batching process I/O. It's
+     * driven by raw system calls, so there is no
+     * dependency on liburing. Instance is not
+     * thread safe.
+     */
+    class IoUring
+    {
+    public:
+        /**
+         * @brief Opcode of `waitid` operation.
+         * It's missing in older kernel headers,
+         * supported by kernel since 6.7.
+         */
+        static constexpr uint8_t WaitIdOpcode = 50;
+
+        /**
+         * @brief Constructor.
+         * @param entries Number of submission
+         * queue entries.
+         * @throws std::runtime_error If kernel
+         * doesn't provide io_uring.
+         */
+        explicit IoUring(unsigned entries);
+
+        /**
+         * @brief Destructor.
+         */
+        ~IoUring();
+
+        IoUring(const IoUring&) = delete;
+        IoUring& operator=(const IoUring&) = delete;
+
+        /**
+         * @brief Method for checking if kernel
+         * supports operation.
+         * @param opcode Operation code.
+         * @return Is operation supported.
+         */
+        bool isSupported(uint8_t opcode) const;
+
+        /**
+         * @brief Method for getting zeroed submission
+         * queue entry. It's submitted by next `submit`.
+         * @return Pointer to entry or nullptr if
+         * submission queue is full.
+         */
+        io_uring_sqe* acquire();
+
+        /**
+         * @brief Method for submitting acquired
+         * entries and waiting for completions.
+         * @param wait Number of completions to wait.
+         * @return Number of submitted entries
+         * or negative error code.
+         */
+        int submit(unsigned wait);
+
+        /**
+         * @brief Method for taking completion
+         * queue entry.
+         * @param cqe Taken entry.
+         * @return Was there any completion.
+         */
+        bool pop(io_uring_cqe& cqe);
+
+        /**
+         * @brief Method for getting ring of
+         * calling thread. It's created on first use.
+         * @return Pointer to ring or nullptr if
+         * io_uring or required operations are
+         * not available.
+         */
+        static IoUring* local();
+
+        /**
+         * @brief Method for destroying ring of
+         * calling thread, if it became unusable.
+         * Kernel cancels it's operations. Next
+         * `local` calls return nullptr.
+         * @param data Memory, that operations may
+         * still use. It's kept until process exit,
+         * because cancellation isn't confirmed.
+         */
+        static void resetLocal(std::shared_ptr<const void> data = nullptr);
+
+    private:
+        int m_fd;
+
+        void* m_ring;
+        std::size_t m_ringSize;
+
+        io_uring_sqe* m_sqes;
+        std::size_t m_sqesSize;
+
+        unsigned* m_sqHead;
+        unsigned* m_sqTail;
+        unsigned* m_sqMask;
+        unsigned* m_sqArray;
+        unsigned m_sqEntries;
+
+        // Tail of acquired but not submitted entries
+        unsigned m_sqLocalTail;
+
+        unsigned* m_cqHead;
+        unsigned* m_cqTail;
+        unsigned* m_cqMask;
+        io_uring_cqe* m_cqes;
+
+        uint8_t m_supported[256];
+    };
+}
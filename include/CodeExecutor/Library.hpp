@@ -1,7 +1,13 @@
 #pragma once
 
+#include <deque>
 #include <memory>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 #include "filesystem.hpp"
+#include "Artifact.hpp"
 #include <functional>
 #include <dlfcn.h>
 
@@ -11,11 +17,18 @@ namespace CodeExecutor
 
     using LibraryPtr = std::shared_ptr<Library>;
 
+    class SymbolRegistry;
+
+    template<class M>
+    class Function;
+
     /**
      * @brief Class, that describes
-     * library.
+     * library. Resolved symbols are cached,
+     * so symbols can be resolved from several
+     * threads at once.
      */
-    class Library
+    class Library : public std::enable_shared_from_this<Library>
     {
     public:
         /**
@@ -28,10 +41,17 @@ namespace CodeExecutor
          */
         explicit Library(const std::filesystem::path& path);
 
+        /**
+         * @brief Constructor from artifact. Library
+         * keeps artifact alive.
+         * @param artifact Shared object artifact.
+         */
+        explicit Library(ArtifactPtr artifact);
+
         /**
          * @brief Destructor.
          */
-        ~Library();
+        virtual ~Library();
 
         /**
          * @brief Method for getting library path.
@@ -50,16 +70,22 @@ namespace CodeExecutor
          * @brief Method for checking is library
          * loaded and ready to use.
          */
-        bool isLoaded() const;
+        virtual bool isLoaded() const;
 
         /**
-         * @brief Method for loading library.
+         * @brief Method for loading library
+         * from path again after unloading.
          * @return Loading success.
          */
         bool load();
 
         /**
          * @brief Method for unloading library.
+         * Cached symbols are dropped and library is
+         * removed from symbol registries. Resolved
+         * pointers become invalid, so it must not be
+         * called while library is used, use
+         * `FunctionSlot` to replace code in use.
          * @return Unloading success.
          */
         bool unload();
@@ -71,38 +97,178 @@ namespace CodeExecutor
          */
         void* resolve(const char* name);
 
+        /**
+         * @brief Method for resolving several
+         * symbols at once. Cache is locked once
+         * for all of them.
+         * @param names Symbol names.
+         * @return Addresses in order of names,
+         * nullptr for missing symbols.
+         */
+        std::vector<void*> resolveAll(const std::vector<std::string>& names);
+
+        /**
+         * @brief Method for getting names of functions
+         * and variables, defined and exported by library.
+         * They are read from ELF dynamic symbol table.
+         * @return Symbol names.
+         */
+        virtual std::vector<std::string> symbols() const;
+
         /**
          * @brief Method for resolving symbols.
          * @tparam M Function type.
          * @param name
-         * @return
+         * @return Function, that keeps library
+         * alive, if library is owned by smart
+         * pointer. Empty if symbol is not found.
          */
         template<class M>
-        std::function<M> resolveFunction(const char* name)
+        Function<M> resolveFunction(const char* name)
         {
-            if (m_library == nullptr)
-            {
-                return nullptr;
-            }
-
-            auto result = dlsym(m_library, name);
-            auto errorString = dlerror();
-            if (errorString)
-            {
-                m_errorString = errorString;
-                return nullptr;
-            }
-
-            return std::function<M>((M*) result);
+            return Function<M>(
+                weak_from_this().lock(),
+                reinterpret_cast<M*>(resolve(name))
+            );
         };
 
+    protected:
+
+        /**
+         * @brief Constructor for derived loaders.
+         * Library is not loaded.
+         * @param path Library path. May be empty.
+         * @param artifact Artifact to keep alive.
+         */
+        Library(std::filesystem::path path, ArtifactPtr artifact);
+
+        /**
+         * @brief Method for loading library. It's
+         * called by `load` if library isn't loaded.
+         * @param errorString Loading error.
+         * @return Loading success.
+         */
+        virtual bool open(std::string& errorString);
+
+        /**
+         * @brief Method for unloading loaded library.
+         * It's called by `unload` after caches are
+         * dropped. Derived class has to call `unload`
+         * in own destructor.
+         * @param errorString Unloading error.
+         * @return Unloading success.
+         */
+        virtual bool close(std::string& errorString);
+
+        /**
+         * @brief Method for finding symbol in
+         * loaded library without cache.
+         * @param name Symbol name.
+         * @param errorString Lookup error.
+         * @return Symbol address or nullptr.
+         */
+        virtual void* lookup(const char* name, std::string& errorString) const;
+
     private:
+        friend class SymbolRegistry;
+
+        void detach();
 
         // Linux specific
         void* m_library;
 
         std::filesystem::path m_path;
         std::string m_errorString;
+
+        ArtifactPtr m_artifact;
+
+        mutable std::shared_mutex m_symbolsMutex;
+
+        // Keys point into names, deque never moves
+        // strings, so lookup doesn't allocate
+        std::deque<std::string> m_names;
+        std::unordered_map<std::string_view, void*> m_symbols;
+
+        std::vector<std::weak_ptr<SymbolRegistry>> m_registries;
     };
-}
 
+    /**
+     * @brief Class, that describes function
+     * of library. It's called directly by
+     * pointer and keeps library alive.
+     */
+    template<class R, class... Args>
+    class Function<R(Args...)>
+    {
+    public:
+        using Pointer = R(*)(Args...);
+
+        /**
+         * @brief Default constructor. Creates
+         * empty function.
+         */
+        Function() :
+            m_library(),
+            m_function(nullptr)
+        {}
+
+        /**
+         * @brief Constructor.
+         * @param library Library, that
+         * defines function.
+         * @param function Function pointer.
+         */
+        Function(LibraryPtr library, Pointer function) :
+            m_library(function ? std::move(library) : nullptr),
+            m_function(function)
+        {}
+
+        /**
+         * @brief Method for calling function.
+         */
+        R operator()(Args... args) const
+        {
+            return m_function(std::forward<Args>(args)...);
+        }
+
+        /**
+         * @brief Method for getting function
+         * pointer. It's valid while library
+         * is alive.
+         * @return Function pointer.
+         */
+        Pointer pointer() const
+        {
+            return m_function;
+        }
+
+        /**
+         * @brief Method for getting library,
+         * that defines function.
+         * @return Smart pointer to library.
+         */
+        const LibraryPtr& library() const
+        {
+            return m_library;
+        }
+
+        explicit operator bool() const
+        {
+            return m_function != nullptr;
+        }
+
+        bool operator==(std::nullptr_t) const
+        {
+            return m_function == nullptr;
+        }
+
+        bool operator!=(std::nullptr_t) const
+        {
+            return m_function != nullptr;
+        }
+
+    private:
+        LibraryPtr m_library;
+        Pointer m_function;
+    };
+}
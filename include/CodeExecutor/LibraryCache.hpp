@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "Library.hpp"
+
+namespace CodeExecutor
+{
+    class LibraryCache;
+
+    using LibraryCachePtr = std::shared_ptr<LibraryCache>;
+
+    /**
+     * @brief Class, that describes in memory
+     * table of loaded libraries. Concurrent requests
+     * for the same missing key share one build:
+     * the first request builds library, others wait
+     * for it's result. Failed builds are not stored.
+     * Number of stored libraries is limited, least
+     * recently used library is evicted first.
+     */
+    class LibraryCache
+    {
+    public:
+        using Factory = std::function<LibraryPtr()>;
+
+        /**
+         * @brief Constructor.
+         * @param capacity Maximum number of stored libraries.
+         */
+        explicit LibraryCache(std::size_t capacity = 1024);
+
+        /**
+         * @brief Method for getting library by key.
+         * If there is no library with such key, it will
+         * be created with factory. If library is being
+         * created by other thread, this method waits for it.
+         * Exceptions thrown by factory are passed to
+         * every waiting caller.
+         * @param key Library key.
+         * @param factory Library factory.
+         * @return Smart pointer to library.
+         */
+        LibraryPtr get(const std::string& key, const Factory& factory);
+
+        /**
+         * @brief Method for checking whether library
+         * with key is built or being built.
+         * @param key Library key.
+         */
+        bool contains(const std::string& key) const;
+
+        /**
+         * @brief Method for removing library from cache.
+         * Library stays loaded while it's used, evicted
+         * libraries are handled the same way.
+         * @param key Library key.
+         */
+        void remove(const std::string& key);
+
+        /**
+         * @brief Method for removing all libraries
+         * from cache.
+         */
+        void clear();
+
+        /**
+         * @brief Method for getting number of stored
+         * libraries.
+         * @return Number of libraries.
+         */
+        std::size_t size() const;
+
+        /**
+         * @brief Method for getting maximum number
+         * of stored libraries.
+         * @return Capacity.
+         */
+        std::size_t capacity() const;
+
+        /**
+         * @brief Method for getting number of requests,
+         * served with stored or being built library.
+         * @return Number of hits.
+         */
+        std::uint64_t hits() const;
+
+        /**
+         * @brief Method for getting number of requests,
+         * that started a build.
+         * @return Number of misses.
+         */
+        std::uint64_t misses() const;
+
+    private:
+
+        using FuturePtr = std::shared_ptr<std::shared_future<LibraryPtr>>;
+
+        // Most recently used keys are in front
+        using UsageContainer = std::list<std::string>;
+
+        struct Entry
+        {
+            FuturePtr future;
+            UsageContainer::iterator usage;
+        };
+
+        using LibrariesContainer = std::unordered_map<std::string, Entry>;
+
+        void erase(LibrariesContainer::iterator library);
+
+        std::size_t m_capacity;
+
+        mutable std::mutex m_mutex;
+        LibrariesContainer m_libraries;
+        UsageContainer m_usage;
+
+        std::atomic<std::uint64_t> m_hits;
+        std::atomic<std::uint64_t> m_misses;
+    };
+}
+
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include "ArtifactStorage.hpp"
 #include "Library.hpp"
 #include "Object.hpp"
 
@@ -22,7 +23,24 @@ namespace CodeExecutor
          */
         virtual ~Linker() = default;
 
+        /**
+         * @brief Method for linking objects into library.
+         * @param objects Objects.
+         * @return Smart pointer to library.
+         */
         virtual LibraryPtr link(const std::vector<ObjectPtr>& objects) = 0;
+
+        /**
+         * @brief Method for linking objects into library,
+         * that is created in storage, unless linker has
+         * own storage. Builder passes it's storage here.
+         * By default storage is ignored.
+         * @param objects Objects.
+         * @param storage Storage or nullptr.
+         * @return Smart pointer to library.
+         */
+        virtual LibraryPtr link(const std::vector<ObjectPtr>& objects,
+                                const ArtifactStoragePtr& storage);
     };
 }
 
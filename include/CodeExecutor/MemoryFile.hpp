@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include "Artifact.hpp"
+
+namespace CodeExecutor
+{
+    class MemoryFile;
+
+    using MemoryFilePtr = std::shared_ptr<MemoryFile>;
+
+    /**
+     * @brief Class, that describes anonymous
+     * file in memory (`memfd`). It's accessible
+     * by `/proc/<pid>/fd/<fd>` path, so child
+     * processes can write to it and `dlopen`
+     * can load it without touching filesystem.
+     */
+    class MemoryFile : public Artifact
+    {
+    public:
+
+        /**
+         * @brief Constructor.
+         * @param name Name, that is shown in
+         * `/proc/<pid>/fd` links.
+         * @throws std::runtime_error If file
+         * can't be created.
+         */
+        explicit MemoryFile(const std::string& name);
+
+        /**
+         * @brief Destructor. Closes file, memory is
+         * freed after last mapping is removed.
+         */
+        ~MemoryFile() override;
+
+        MemoryFile(const MemoryFile&) = delete;
+        MemoryFile& operator=(const MemoryFile&) = delete;
+
+        /**
+         * @copydoc Artifact::path
+         */
+        std::filesystem::path path() const override;
+
+        /**
+         * @brief Method for getting file descriptor.
+         * @return Descriptor.
+         */
+        int descriptor() const;
+
+        /**
+         * @brief Method for getting current
+         * file size.
+         * @return Size in bytes.
+         */
+        std::size_t size() const;
+
+    private:
+        int m_descriptor;
+        std::filesystem::path m_path;
+    };
+}
+
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "ArtifactStorage.hpp"
+
+namespace CodeExecutor
+{
+    /**
+     * @brief Class, that describes storage,
+     * that keeps artifacts in memory files.
+     * Nothing is written to filesystem.
+     */
+    class MemoryStorage : public ArtifactStorage
+    {
+    public:
+
+        /**
+         * @copydoc ArtifactStorage::create
+         */
+        ArtifactPtr create(const std::string& name) override;
+    };
+}
+
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <memory>
+#include <string>
 #include "filesystem.hpp"
+#include "Artifact.hpp"
 
 namespace CodeExecutor
 {
@@ -18,8 +20,31 @@ namespace CodeExecutor
         /**
          * @brief Constructor.
          * @param file Path to object file.
+         * @param standardOutput Compiler standard output.
+         * @param standardError Compiler standard error.
          */
-        explicit Object(const std::filesystem::path& file);
+        explicit Object(const std::filesystem::path& file,
+                        std::string standardOutput = std::string(),
+                        std::string standardError = std::string());
+
+        /**
+         * @brief Constructor from artifact. Object
+         * keeps artifact alive.
+         * @param artifact Object file artifact.
+         * @param standardOutput Compiler standard output.
+         * @param standardError Compiler standard error.
+         */
+        explicit Object(ArtifactPtr artifact,
+                        std::string standardOutput = std::string(),
+                        std::string standardError = std::string());
+
+        /**
+         * @brief Method for getting artifact, that
+         * holds object file.
+         * @return Artifact or nullptr, if object
+         * is a plain file.
+         */
+        ArtifactPtr artifact() const;
 
         /**
          * @brief Method for getting path to the
@@ -28,9 +53,28 @@ namespace CodeExecutor
          */
         std::filesystem::path path() const;
 
+        /**
+         * @brief Method for getting standard output
+         * of compiler, that produced this object.
+         * @return Standard output.
+         */
+        const std::string& standardOutput() const;
+
+        /**
+         * @brief Method for getting standard error
+         * of compiler, that produced this object.
+         * It contains compiler warnings.
+         * @return Standard error.
+         */
+        const std::string& standardError() const;
+
     private:
 
         std::filesystem::path m_path;
+        ArtifactPtr m_artifact;
+
+        std::string m_stdout;
+        std::string m_stderr;
 
     };
 }
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <memory>
+#include "Linker.hpp"
+
+namespace CodeExecutor
+{
+    /**
+     * @brief Class, that describes linker, that
+     * links objects in process with LLVM ORC JIT.
+     * Every library is separate JIT dylib, symbols
+     * of process are visible to it. Functions of
+     * `.init_array` sections are run after linkage,
+     * functions of `.fini_array` sections and
+     * destructors of static objects are run
+     * on unloading. Objects with legacy constructor
+     * or destructor sections are not loaded. It's available
+     * if library is built with
+     * `CODEEXECUTOR_BUILD_LLVM`.
+     */
+    class OrcLinker : public Linker
+    {
+    public:
+
+        /**
+         * @brief Constructor. Creates JIT
+         * for host target.
+         * @throws std::runtime_error If JIT
+         * can't be created.
+         */
+        OrcLinker();
+
+        /**
+         * @brief Destructor. JIT is destroyed
+         * after last linked library.
+         */
+        ~OrcLinker() override;
+
+        OrcLinker(const OrcLinker&) = delete;
+        OrcLinker& operator=(const OrcLinker&) = delete;
+
+        using Linker::link;
+
+        /**
+         * @copydoc Linker::link(const std::vector<ObjectPtr>&)
+         */
+        LibraryPtr link(const std::vector<ObjectPtr>& objects) override;
+
+    private:
+
+        /**
+         * @brief Structure, that owns JIT. It's
+         * shared by linker and libraries.
+         */
+        struct State;
+
+        /**
+         * @brief Class, that describes library
+         * in JIT dylib.
+         */
+        class Module;
+
+        std::shared_ptr<State> m_state;
+    };
+}
@@ -1,11 +1,21 @@
 #pragma once
 
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <sstream>
 #include <string>
 #include <vector>
+#include <sys/resource.h>
+#include <sys/types.h>
 #include "filesystem.hpp"
+#include "ControlGroup.hpp"
+#include "ForkServer.hpp"
 
 namespace CodeExecutor
 {
+    class IoUring;
+
     /**
      * @brief Class, that describes
      * runnable process.
@@ -14,6 +24,38 @@ namespace CodeExecutor
     {
     public:
         using ArgumentsContainer = std::vector<std::string>;
+        using OutputCallback = std::function<void(const char*, std::size_t)>;
+
+        /**
+         * @brief Structure, that describes resources,
+         * used by finished process.
+         */
+        struct ResourceUsage
+        {
+            std::chrono::microseconds userTime;
+            std::chrono::microseconds systemTime;
+
+            // Peak resident set size in bytes
+            std::size_t maxResidentSetSize;
+
+            std::size_t minorPageFaults;
+            std::size_t majorPageFaults;
+        };
+
+        /**
+         * @brief Engine, that performs I/O with
+         * child process.
+         */
+        enum class IoEngine
+        {
+            // Nonblocking pipes are served by poll
+            Poll,
+
+            // Writes, reads and child exit waiting are
+            // batched by io_uring of calling thread. If
+            // kernel doesn't support it, poll is used.
+            Uring
+        };
 
         /**
          * @brief Default constructor.
@@ -34,10 +76,19 @@ namespace CodeExecutor
         /**
          * @brief Method for getting process
          * result exit code.
-         * @return Exit code.
+         * @return Exit code. If process was killed
+         * by signal, it's 128 + signal number.
          */
         int exitCode() const;
 
+        /**
+         * @brief Method for getting resources,
+         * used by finished process.
+         * @return Resource usage. It's zero, if
+         * process wasn't started.
+         */
+        const ResourceUsage& resourceUsage() const;
+
         /**
          * @brief Get stderr content.
          * @return Error output.
@@ -128,13 +179,219 @@ namespace CodeExecutor
          */
         std::string inputData() const;
 
+        /**
+         * @brief Method for setting buffer, that is
+         * redirected to program's stdin. Buffer is
+         * shared, not copied. It's passed to pipe
+         * by reference with `vmsplice`, so it must
+         * not be modified.
+         * @param data Buffer. `nullptr` means no input.
+         */
+        void setInputBuffer(std::shared_ptr<const std::string> data);
+
+        /**
+         * @brief Method for getting buffer, that is
+         * redirected to program's stdin.
+         * @return Buffer.
+         */
+        std::shared_ptr<const std::string> inputBuffer() const;
+
+        /**
+         * @brief Method for setting callback, that
+         * receives stdout chunks as soon as they are
+         * read. It's called from thread, that started
+         * process.
+         * @param callback Callback.
+         */
+        void setStandardOutputCallback(OutputCallback callback);
+
+        /**
+         * @brief Method for setting callback, that
+         * receives stderr chunks as soon as they are
+         * read. It's called from thread, that started
+         * process.
+         * @param callback Callback.
+         */
+        void setStandardErrorCallback(OutputCallback callback);
+
+        /**
+         * @brief Method for setting maximum amount of
+         * bytes captured from each of stdout and stderr.
+         * Rest of output is still read and passed to
+         * callbacks, but not stored.
+         * @param bytes Limit. 0 means unlimited.
+         */
+        void setCaptureLimit(std::size_t bytes);
+
+        /**
+         * @brief Method for getting maximum amount
+         * of captured bytes.
+         * @return Limit. 0 means unlimited.
+         */
+        std::size_t captureLimit() const;
+
+        /**
+         * @brief Method for setting I/O engine,
+         * used by `start`.
+         * @param engine Engine.
+         */
+        void setIoEngine(IoEngine engine);
+
+        /**
+         * @brief Method for getting I/O engine.
+         * @return Engine.
+         */
+        IoEngine ioEngine() const;
+
+        /**
+         * @brief Method for setting control group,
+         * that process is placed into. Process joins
+         * group before program is executed. If process
+         * is spawned by host, it's forked instead of
+         * `posix_spawn` for that.
+         * @param group Control group. `nullptr`
+         * means no group.
+         */
+        void setControlGroup(ControlGroupPtr group);
+
+        /**
+         * @brief Method for getting control group,
+         * that process is placed into.
+         * @return Control group.
+         */
+        ControlGroupPtr controlGroup() const;
+
+        /**
+         * @brief Method for setting fork server,
+         * that spawns this process.
+         * @param server Fork server. `nullptr` means
+         * process wide fork server, if it's set.
+         */
+        void setForkServer(ForkServerPtr server);
+
+        /**
+         * @brief Method for getting fork server,
+         * that spawns this process.
+         * @return Fork server.
+         */
+        ForkServerPtr forkServer() const;
+
         /**
          * @brief Method for starting process.
-         * @return Execution result.
+         * If fork server is set, process is spawned
+         * by it. If fork server is not available,
+         * process is spawned by host process with
+         * `posix_spawn`. It's safe to start different
+         * processes from different threads at once.
+         * @return Execution result. If program can't
+         * be started, it's 127.
          */
         int start();
 
     private:
+        friend class ProcessPool;
+
+        // Function, that waits for child, collects
+        // used resources and returns it's wait status
+        using Waiter = std::function<int(rusage&)>;
+
+        /**
+         * @brief Structure, that describes
+         * launched child process.
+         */
+        struct Launched
+        {
+            // Write end of child stdin
+            int input;
+
+            // Read ends of child stdout and stderr
+            int output;
+            int error;
+
+            // Child process id, if it's spawned by host
+            pid_t pid;
+
+            // Descriptor, that becomes readable on
+            // child exit, or -1. It's released by `wait`.
+            int waitDescriptor;
+
+            // Function, that waits for child
+            Waiter wait;
+        };
+
+        /**
+         * @brief Method for launching process
+         * without communicating with it.
+         * @param launched Launched process descriptors.
+         * @param watchable Is wait descriptor required.
+         * @return Was process launched. If not, exit code
+         * is already set.
+         */
+        bool launch(Launched& launched, bool watchable);
+
+        /**
+         * @brief Method for handling chunk of
+         * child output.
+         * @param error Is chunk read from stderr.
+         * @param data Chunk data.
+         * @param size Chunk size.
+         */
+        void consumeOutput(bool error, const char* data, std::size_t size);
+
+        /**
+         * @brief Method for setting process result.
+         * @param status Wait status or -1.
+         * @param usage Resources, used by child.
+         */
+        void finish(int status, const rusage& usage);
+
+        /**
+         * @brief Method for spawning process from
+         * host process. Standard descriptors of host
+         * are not touched.
+         * @param input Child stdin descriptor.
+         * @param output Child stdout descriptor.
+         * @param error Child stderr descriptor.
+         * @return Child process id or -1.
+         */
+        pid_t spawn(int input, int output, int error);
+
+        /**
+         * @brief Method for passing input to
+         * spawned process and collecting it's output.
+         * Input is written and output is read at
+         * the same time. Descriptors are closed.
+         * @param input Write end of child stdin or -1.
+         * @param output Read end of child stdout or -1.
+         * @param error Read end of child stderr or -1.
+         * @param written Size of already written input.
+         * @param wait Function, that waits for child.
+         */
+        void communicate(int input,
+                         int output,
+                         int error,
+                         std::size_t written,
+                         const Waiter& wait);
+
+        /**
+         * @brief Method for passing input to
+         * spawned process and collecting it's output
+         * with io_uring. Descriptors are closed.
+         * If ring fails, operations in flight are
+         * cancelled and poll is used for the rest.
+         * @param ring Ring of calling thread.
+         * @param launched Launched process.
+         */
+        void communicate(IoUring& ring, Launched& launched);
+
+        /**
+         * @brief Method for writing next part of
+         * input to child stdin without blocking.
+         * @param fd Write end of child stdin.
+         * @param offset Size of already written part.
+         * @return Number of written bytes or -1.
+         */
+        ssize_t writeInput(int fd, std::size_t offset);
 
         bool makeNonBlocking(int fd);
 
@@ -142,7 +399,7 @@ namespace CodeExecutor
         std::filesystem::path m_program;
         ArgumentsContainer m_arguments;
 
-        std::string m_inputData;
+        std::shared_ptr<const std::string> m_inputData;
 
         std::filesystem::path m_stdoutFile;
         std::filesystem::path m_stderrFile;
@@ -150,7 +407,24 @@ namespace CodeExecutor
         std::stringstream m_stderrStream;
         std::stringstream m_stdoutStream;
 
+        OutputCallback m_stdoutCallback;
+        OutputCallback m_stderrCallback;
+
+        std::size_t m_captureLimit;
+        std::size_t m_stdoutCaptured;
+        std::size_t m_stderrCaptured;
+
+        IoEngine m_ioEngine;
+
         int m_exitCode;
+
+        ForkServerPtr m_forkServer;
+
+        ResourceUsage m_resourceUsage;
+
+        ControlGroupPtr m_controlGroup;
     };
+
+    using ProcessPtr = std::shared_ptr<Process>;
 }
 
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "Process.hpp"
+
+namespace CodeExecutor
+{
+    class ProcessPool;
+
+    using ProcessPoolPtr = std::shared_ptr<ProcessPool>;
+
+    /**
+     * @brief Class, that describes reactor, that
+     * runs many processes from one thread. Pipes
+     * of all processes and descriptors, signalling
+     * their exit, are watched by one epoll set.
+     */
+    class ProcessPool
+    {
+    public:
+        using Callback = std::function<void(const ProcessPtr&)>;
+
+        /**
+         * @brief Constructor. Starts reactor thread.
+         * @throws std::runtime_error If epoll can't
+         * be created.
+         */
+        ProcessPool();
+
+        /**
+         * @brief Destructor. Waits for all launched
+         * processes to finish.
+         */
+        ~ProcessPool();
+
+        ProcessPool(const ProcessPool&) = delete;
+        ProcessPool& operator=(const ProcessPool&) = delete;
+
+        /**
+         * @brief Method for launching process.
+         * Process is spawned by calling thread and
+         * then is handled by reactor.
+         * @param process Process. It must not be
+         * started or launched again until finished.
+         * @return Future with process exit code.
+         */
+        std::future<int> launch(ProcessPtr process);
+
+        /**
+         * @brief Method for launching process.
+         * Callback is called from reactor thread
+         * after process is finished, or from calling
+         * thread if process can't be spawned.
+         * Exceptions, thrown by callback, are ignored.
+         * Output callbacks of process are called
+         * from reactor thread too.
+         * @param process Process.
+         * @param callback Completion callback.
+         */
+        void launch(ProcessPtr process, Callback callback);
+
+        /**
+         * @brief Method for getting number of
+         * launched and not yet finished processes.
+         * @return Number of processes.
+         */
+        std::size_t running() const;
+
+    private:
+
+        /**
+         * @brief Structure, that describes process,
+         * handled by reactor.
+         */
+        struct Entry;
+
+        /**
+         * @brief Structure, that describes watched
+         * descriptor. Pointer to it is stored in epoll.
+         */
+        struct Watch
+        {
+            Entry* entry;
+            int kind;
+        };
+
+        struct Entry
+        {
+            ProcessPtr process;
+            Callback callback;
+            Process::Launched launched;
+            std::size_t written;
+            bool exited;
+
+            // Child without wait descriptor is reaped
+            // by reactor without blocking
+            bool reaped;
+            int status;
+            rusage usage;
+
+            Watch watches[4];
+        };
+
+        void run();
+
+        void add(std::unique_ptr<Entry> entry);
+
+        void handle(Watch& watch);
+
+        void release(int& fd);
+
+        bool reap(Entry& entry);
+
+        void complete(Entry& entry);
+
+        int m_epoll;
+        int m_wakeup;
+
+        mutable std::mutex m_mutex;
+        std::vector<std::unique_ptr<Entry>> m_pending;
+        bool m_stopping;
+
+        std::atomic<std::size_t> m_running;
+
+        // Accessed only by reactor thread
+        std::unordered_map<Entry*, std::unique_ptr<Entry>> m_entries;
+
+        std::thread m_thread;
+    };
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace CodeExecutor
+{
+    /**
+     * @brief Class, that calculates SHA-256
+     * digest. It's used as strong content
+     * hash for naming build artifacts. SHA
+     * extensions of x86 CPUs are used, if
+     * they are available.
+     */
+    class Sha256
+    {
+    public:
+        using Digest = std::array<std::uint8_t, 32>;
+
+        /**
+         * @brief Constructor.
+         */
+        Sha256();
+
+        /**
+         * @brief Method for appending data to
+         * hashed message.
+         * @param data Pointer to data.
+         * @param size Data size in bytes.
+         */
+        void update(const void* data, std::size_t size);
+
+        /**
+         * @brief Method for appending string
+         * to hashed message.
+         * @param data String.
+         */
+        void update(const std::string& data);
+
+        /**
+         * @brief Method for finishing calculation.
+         * Object must not be updated after it.
+         * @return Digest.
+         */
+        Digest digest();
+
+        /**
+         * @brief Method for finishing calculation.
+         * Object must not be updated after it.
+         * @return Lowercase hex digest string.
+         */
+        std::string hexDigest();
+
+        /**
+         * @brief Method for calculating hex digest
+         * of string.
+         * @param data String.
+         * @return Lowercase hex digest string.
+         */
+        static std::string hash(const std::string& data);
+
+        /**
+         * @brief Method for converting digest to
+         * lowercase hex string.
+         * @param digest Digest.
+         * @return Hex string.
+         */
+        static std::string toHex(const Digest& digest);
+
+        /**
+         * @brief Method for checking if hashing
+         * is accelerated by CPU instructions.
+         * @return Is hashing accelerated.
+         */
+        static bool isAccelerated();
+
+    private:
+
+        void processBlocks(const std::uint8_t* blocks, std::size_t count);
+
+        void processBlock(const std::uint8_t* block);
+
+        std::array<std::uint32_t, 8> m_state;
+        std::array<std::uint8_t, 64> m_buffer;
+        std::size_t m_bufferSize;
+        std::uint64_t m_length;
+    };
+}
+
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
 
 namespace CodeExecutor
 {
@@ -10,7 +13,9 @@ namespace CodeExecutor
 
     /**
      * @brief Class, that describes
-     * source file content.
+     * source file content. Content is kept
+     * in immutable buffer, that can be shared
+     * without copying.
      */
     class Source
     {
@@ -19,9 +24,9 @@ namespace CodeExecutor
 
         /**
          * @brief Hidden constructor.
-         * @param content Content.
+         * @param content Content buffer.
          */
-        explicit Source(std::string content, HideArg);
+        explicit Source(std::shared_ptr<const std::string> content, HideArg);
 
         Source(const Source&) = delete;
         Source& operator=(const Source&) = delete;
@@ -34,17 +39,60 @@ namespace CodeExecutor
          */
         static SourcePtr createFromSource(std::string content);
 
+        /**
+         * @brief Virtual constructor, that shares
+         * existing buffer.
+         * @param content Buffer with source code
+         * content. `nullptr` means empty source.
+         * @return Source object pointer.
+         */
+        static SourcePtr createFromBuffer(std::shared_ptr<const std::string> content);
+
 //        static SourcePtr createFromFile
 
         /**
          * @brief Method for getting source content.
-         * @return String with source content.
+         * @return String with source content. It's
+         * valid while source exists.
          */
-        std::string content() const;
+        const std::string& content() const;
+
+        /**
+         * @brief Method for getting source content
+         * view.
+         * @return View of source content. It's
+         * valid while source exists.
+         */
+        std::string_view contentView() const;
+
+        /**
+         * @brief Method for getting buffer with
+         * source content.
+         * @return Buffer.
+         */
+        std::shared_ptr<const std::string> buffer() const;
+
+        /**
+         * @brief Method for getting content size.
+         * @return Size in bytes.
+         */
+        std::size_t size() const;
+
+        /**
+         * @brief Method for getting content
+         * fingerprint. It's SHA-256 of content, that
+         * is calculated on first call and cached.
+         * It's used for naming build artifacts.
+         * @return Lowercase hex digest string.
+         */
+        const std::string& fingerprint() const;
 
     private:
 
-        std::string m_content;
+        std::shared_ptr<const std::string> m_content;
+
+        mutable std::once_flag m_fingerprintFlag;
+        mutable std::string m_fingerprint;
     };
 }
 
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Library.hpp"
+
+namespace CodeExecutor
+{
+    class SymbolRegistry;
+
+    using SymbolRegistryPtr = std::shared_ptr<SymbolRegistry>;
+
+    /**
+     * @brief Class, that describes index of
+     * symbols, exported by live libraries. It
+     * finds library, that defines symbol, without
+     * walking every library. If several libraries
+     * define same symbol, the last added live one
+     * is used. Libraries are removed from registry,
+     * when they are unloaded or destroyed.
+     */
+    class SymbolRegistry : public std::enable_shared_from_this<SymbolRegistry>
+    {
+    public:
+
+        /**
+         * @brief Structure, that describes
+         * found symbol. Library is kept alive
+         * while symbol is used.
+         */
+        struct Symbol
+        {
+            LibraryPtr library;
+            void* address;
+        };
+
+        /**
+         * @brief Constructor.
+         */
+        SymbolRegistry();
+
+        SymbolRegistry(const SymbolRegistry&) = delete;
+        SymbolRegistry& operator=(const SymbolRegistry&) = delete;
+
+        /**
+         * @brief Method for adding all symbols,
+         * exported by library. Registry must be
+         * owned by smart pointer. Library, that
+         * is already added, is ignored.
+         * @param library Loaded library.
+         * @return Number of added symbols.
+         */
+        std::size_t add(const LibraryPtr& library);
+
+        /**
+         * @brief Method for removing symbols,
+         * owned by library.
+         * @param library Library.
+         */
+        void remove(const Library* library);
+
+        /**
+         * @brief Method for finding symbol.
+         * @param name Symbol name.
+         * @return Symbol. Library is nullptr
+         * if symbol is not found.
+         */
+        Symbol find(const std::string& name) const;
+
+        /**
+         * @brief Method for getting number of
+         * registered symbols.
+         * @return Number of symbols.
+         */
+        std::size_t size() const;
+
+        /**
+         * @brief Method for getting process wide
+         * registry.
+         * @return Smart pointer to registry.
+         */
+        static SymbolRegistryPtr global();
+
+    private:
+
+        struct Entry
+        {
+            const Library* owner;
+            std::weak_ptr<Library> library;
+            void* address;
+        };
+
+        // Owners of every symbol, the last
+        // added one is at the back
+        using OwnersContainer = std::vector<Entry>;
+
+        mutable std::shared_mutex m_mutex;
+        std::unordered_map<std::string, OwnersContainer> m_symbols;
+
+        // Names, that are currently owned by library
+        std::unordered_map<const Library*, std::vector<std::string>> m_owned;
+    };
+}
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <typeindex>
+#include <vector>
+#include "FunctionSlot.hpp"
+#include "Library.hpp"
+
+namespace CodeExecutor
+{
+    class TieredLibrary;
+
+    using TieredLibraryPtr = std::shared_ptr<TieredLibrary>;
+
+    template<class M>
+    class TieredFunction;
+
+    /**
+     * @brief Class, that describes library, which
+     * is first built fast and then replaced by
+     * optimized build. Functions, resolved from it,
+     * are function slots, that call the best
+     * available build. All builds stay loaded
+     * while tiered library is alive.
+     */
+    class TieredLibrary : public std::enable_shared_from_this<TieredLibrary>
+    {
+    public:
+
+        /**
+         * @brief Constructor.
+         * @param library Fast built library.
+         */
+        explicit TieredLibrary(LibraryPtr library);
+
+        TieredLibrary(const TieredLibrary&) = delete;
+        TieredLibrary& operator=(const TieredLibrary&) = delete;
+
+        /**
+         * @brief Method for getting the best
+         * available library.
+         * @return Smart pointer to library.
+         */
+        LibraryPtr library() const;
+
+        /**
+         * @brief Method for checking is optimized
+         * library installed.
+         */
+        bool isOptimized() const;
+
+        /**
+         * @brief Method for waiting until optimized
+         * library is installed or optimization fails.
+         * @return Is optimized library installed.
+         */
+        bool waitOptimized() const;
+
+        /**
+         * @brief Method for getting optimization error.
+         * @return Exception, thrown by optimized build,
+         * or `nullptr`.
+         */
+        std::exception_ptr optimizationError() const;
+
+        /**
+         * @brief Method for installing optimized
+         * library. Resolved functions are switched
+         * to it. Functions, missing in optimized
+         * library, keep calling fast build. If
+         * library is not loaded, optimization fails.
+         * @param library Optimized library.
+         */
+        void promote(LibraryPtr library);
+
+        /**
+         * @brief Method for marking optimization
+         * as failed. Fast build is used further.
+         * @param error Optimization error.
+         */
+        void fail(std::exception_ptr error);
+
+        /**
+         * @brief Method for resolving function.
+         * @tparam M Function type.
+         * @param name Function name.
+         * @return Function, that calls the best
+         * available build. Empty if symbol is
+         * not found.
+         */
+        template<class M>
+        TieredFunction<M> resolveFunction(const char* name)
+        {
+            auto result = slot(
+                name,
+                typeid(M),
+                [](const char* name)
+                {
+                    auto function = std::make_shared<FunctionSlot<M>>(name);
+
+                    return Slot{
+                        function,
+                        [function](const LibraryPtr& library)
+                        {
+                            return function->publish(library);
+                        }
+                    };
+                }
+            );
+
+            return TieredFunction<M>(
+                shared_from_this(),
+                std::static_pointer_cast<FunctionSlot<M>>(std::move(result))
+            );
+        }
+
+    private:
+
+        /**
+         * @brief Structure, that describes function
+         * slot with erased type.
+         */
+        struct Slot
+        {
+            std::shared_ptr<void> function;
+            std::function<bool(const LibraryPtr&)> publish;
+        };
+
+        using SlotFactory = std::function<Slot(const char*)>;
+
+        /**
+         * @brief Method for getting function slot
+         * for symbol. New slot is published with
+         * the best build, that has symbol.
+         * @param name Symbol name.
+         * @param type Function type.
+         * @param factory Function, that creates slot.
+         * @return Pointer to `FunctionSlot` or
+         * `nullptr` if symbol is not found.
+         */
+        std::shared_ptr<void> slot(const char* name,
+                                   std::type_index type,
+                                   const SlotFactory& factory);
+
+        mutable std::mutex m_mutex;
+        mutable std::condition_variable m_condition;
+
+        std::vector<LibraryPtr> m_libraries;
+        std::map<std::pair<std::string, std::type_index>, Slot> m_slots;
+
+        bool m_optimized;
+        bool m_finished;
+        std::exception_ptr m_error;
+    };
+
+    /**
+     * @brief Class, that describes function
+     * of tiered library. It keeps library alive.
+     * Calls go through function slot, so build is
+     * switched while function is called.
+     */
+    template<class R, class... Args>
+    class TieredFunction<R(Args...)>
+    {
+    public:
+
+        /**
+         * @brief Default constructor. Creates
+         * empty function.
+         */
+        TieredFunction() :
+            m_library(),
+            m_slot()
+        {}
+
+        /**
+         * @brief Constructor.
+         * @param library Tiered library.
+         * @param slot Function slot.
+         */
+        TieredFunction(TieredLibraryPtr library, std::shared_ptr<FunctionSlot<R(Args...)>> slot) :
+            m_library(slot ? std::move(library) : nullptr),
+            m_slot(std::move(slot))
+        {}
+
+        /**
+         * @brief Method for calling function
+         * of the best available build.
+         */
+        R operator()(Args... args) const
+        {
+            return (*m_slot)(std::forward<Args>(args)...);
+        }
+
+        explicit operator bool() const
+        {
+            return m_slot != nullptr;
+        }
+
+        bool operator==(std::nullptr_t) const
+        {
+            return m_slot == nullptr;
+        }
+
+        bool operator!=(std::nullptr_t) const
+        {
+            return m_slot != nullptr;
+        }
+
+    private:
+        TieredLibraryPtr m_library;
+        std::shared_ptr<FunctionSlot<R(Args...)>> m_slot;
+    };
+}
+
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "Source.hpp"
+
+namespace CodeExecutor
+{
+    /**
+     * @brief Class, that groups sources into
+     * unity (jumbo) translation units. Sources,
+     * that declare the same names at namespace
+     * scope (including anonymous namespaces and
+     * `static` declarations), are never placed
+     * into one unit, because such names would
+     * be redefined.
+     */
+    class UnityBatcher
+    {
+    public:
+        using NamesContainer = std::unordered_set<std::string>;
+        using BatchContainer = std::vector<std::size_t>;
+        using BatchesContainer = std::vector<BatchContainer>;
+
+        /**
+         * @brief Constructor.
+         * @param batchSize Maximum number of sources
+         * in one unit. 0 is treated as 1.
+         */
+        explicit UnityBatcher(std::size_t batchSize);
+
+        /**
+         * @brief Method for grouping sources.
+         * Sources are placed greedily into the first
+         * unit without name clashes.
+         * @param sources Sources.
+         * @return Groups of source indices. Indices in
+         * every group are in ascending order.
+         */
+        BatchesContainer batch(const std::vector<SourcePtr>& sources) const;
+
+        /**
+         * @brief Method for merging sources into one
+         * translation unit. Every source is preceded
+         * by `#line` directive and macros, defined by
+         * source, are undefined after it.
+         * @param sources Sources.
+         * @param names Names of sources for diagnostics.
+         * @return Merged source.
+         */
+        static SourcePtr merge(const std::vector<SourcePtr>& sources,
+                               const std::vector<std::string>& names);
+
+        /**
+         * @brief Method for extracting names, that are
+         * declared at namespace scope. Extraction is
+         * heuristic and may return more names, than
+         * actually declared.
+         * @param content Source content.
+         * @return Names.
+         */
+        static NamesContainer declaredNames(const std::string& content);
+
+        /**
+         * @brief Method for extracting names of macros,
+         * defined by source.
+         * @param content Source content.
+         * @return Macro names in definition order.
+         */
+        static std::vector<std::string> macroNames(const std::string& content);
+
+    private:
+        std::size_t m_batchSize;
+    };
+}
+
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include "ArtifactStorage.hpp"
+
+namespace CodeExecutor
+{
+    class Workspace;
+
+    using WorkspacePtr = std::shared_ptr<Workspace>;
+
+    /**
+     * @brief Class, that describes scratch directory,
+     * where artifacts are created as files. Directory
+     * name is unique across processes, every artifact
+     * file is removed when last reference to it is
+     * released and directory is removed when both
+     * workspace and all artifacts are released.
+     */
+    class Workspace : public ArtifactStorage
+    {
+    public:
+
+        /**
+         * @brief Constructor. Creates directory
+         * inside of `defaultRoot()`.
+         * @throws std::runtime_error If directory
+         * can't be created.
+         */
+        Workspace();
+
+        /**
+         * @brief Constructor. Creates directory
+         * inside of root.
+         * @param root Parent directory.
+         * @throws std::runtime_error If directory
+         * can't be created.
+         */
+        explicit Workspace(const std::filesystem::path& root);
+
+        Workspace(const Workspace&) = delete;
+        Workspace& operator=(const Workspace&) = delete;
+
+        /**
+         * @copydoc ArtifactStorage::create
+         */
+        ArtifactPtr create(const std::string& name) override;
+
+        /**
+         * @brief Method for getting workspace
+         * directory path.
+         * @return Path to directory.
+         */
+        std::filesystem::path path() const;
+
+        /**
+         * @brief Method for getting number of
+         * created and not yet released artifacts.
+         * @return Number of artifacts.
+         */
+        std::size_t size() const;
+
+        /**
+         * @brief Method for getting directory for
+         * workspaces. It's `/dev/shm` if it's
+         * available, so artifacts are kept in
+         * memory, and temporary directory otherwise.
+         * @return Path to directory.
+         */
+        static std::filesystem::path defaultRoot();
+
+    private:
+
+        /**
+         * @brief Structure, that owns directory.
+         * It's shared by workspace and artifacts.
+         */
+        struct Directory;
+
+        /**
+         * @brief Class, that describes file
+         * in workspace.
+         */
+        class File;
+
+        std::shared_ptr<Directory> m_directory;
+        std::atomic<unsigned long long> m_counter;
+    };
+}
@@ -0,0 +1,392 @@
+#include <algorithm>
+#include <fstream>
+#include <unistd.h>
+#include "CodeExecutor/BuildService.hpp"
+
+bool CodeExecutor::BuildService::JobOrder::operator()(const Job& lhs, const Job& rhs) const
+{
+    // Returns true, if `lhs` must be started after `rhs`
+    if (lhs.priority != rhs.priority)
+    {
+        return lhs.priority < rhs.priority;
+    }
+
+    if (lhs.expectedDuration != rhs.expectedDuration)
+    {
+        return lhs.expectedDuration < rhs.expectedDuration;
+    }
+
+    return lhs.sequence > rhs.sequence;
+}
+
+CodeExecutor::BuildService::BuildService(unsigned int concurrency,
+                                         std::uint64_t memoryPerBuild,
+                                         std::size_t historySize) :
+    m_compileSlots(),
+    m_memoryPerBuild(memoryPerBuild),
+    m_historySize(historySize),
+    m_mutex(),
+    m_condition(),
+    m_deadlineCondition(),
+    m_jobs(),
+    m_sequence(0),
+    m_running(0),
+    m_stopping(false),
+    m_history(),
+    m_historyIndex(),
+    m_threads(),
+    m_deadlineThread()
+{
+    if (concurrency == 0)
+    {
+        concurrency = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Builders have own jobs count, so compiler
+    // processes are limited across builds
+    m_compileSlots = std::make_shared<CompileSlots>(concurrency);
+
+    m_threads.reserve(concurrency);
+
+    for (unsigned int i = 0; i < concurrency; ++i)
+    {
+        m_threads.emplace_back(&BuildService::run, this);
+    }
+
+    m_deadlineThread = std::thread(&BuildService::expire, this);
+}
+
+CodeExecutor::BuildService::~BuildService()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_stopping = true;
+    }
+
+    m_condition.notify_all();
+    m_deadlineCondition.notify_one();
+
+    for (auto&& thread : m_threads)
+    {
+        thread.join();
+    }
+
+    m_deadlineThread.join();
+
+    for (auto&& job : m_jobs)
+    {
+        job.promise->set_exception(
+            std::make_exception_ptr(std::runtime_error("Build service stopped"))
+        );
+    }
+}
+
+std::future<CodeExecutor::LibraryPtr> CodeExecutor::BuildService::submit(CodeExecutor::BuilderPtr builder,
+                                                                          int priority,
+                                                                          Clock::time_point deadline)
+{
+    auto promise = std::make_shared<std::promise<LibraryPtr>>();
+    auto future = promise->get_future();
+
+    std::string fingerprint;
+
+    try
+    {
+        if (builder == nullptr)
+        {
+            throw std::invalid_argument("No builder specified");
+        }
+
+        fingerprint = builder->fingerprint();
+    }
+    catch (...)
+    {
+        promise->set_exception(std::current_exception());
+
+        return future;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto history = m_historyIndex.find(fingerprint);
+        auto duration = Clock::duration::zero();
+
+        if (history != m_historyIndex.end())
+        {
+            m_history.splice(m_history.begin(), m_history, history->second);
+
+            duration = history->second->second;
+        }
+
+        m_jobs.push_back({
+            std::move(builder),
+            fingerprint,
+            priority,
+            duration,
+            deadline,
+            m_sequence++,
+            promise
+        });
+
+        std::push_heap(m_jobs.begin(), m_jobs.end(), JobOrder());
+    }
+
+    m_condition.notify_one();
+
+    if (deadline != Clock::time_point::max())
+    {
+        m_deadlineCondition.notify_one();
+    }
+
+    return future;
+}
+
+unsigned int CodeExecutor::BuildService::concurrency() const
+{
+    return static_cast<unsigned int>(m_threads.size());
+}
+
+std::size_t CodeExecutor::BuildService::pending() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_jobs.size();
+}
+
+CodeExecutor::BuildService::Clock::duration
+CodeExecutor::BuildService::expectedDuration(const std::string& fingerprint) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto history = m_historyIndex.find(fingerprint);
+
+    if (history == m_historyIndex.end())
+    {
+        return Clock::duration::zero();
+    }
+
+    return history->second->second;
+}
+
+std::size_t CodeExecutor::BuildService::historySize() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_history.size();
+}
+
+void CodeExecutor::BuildService::clearHistory()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_historyIndex.clear();
+    m_history.clear();
+}
+
+void CodeExecutor::BuildService::run()
+{
+    while (true)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        while (!m_stopping)
+        {
+            if (m_jobs.empty())
+            {
+                m_condition.wait(lock);
+            }
+            else if (canStart())
+            {
+                break;
+            }
+            else
+            {
+                // Memory is checked again later
+                m_condition.wait_for(lock, std::chrono::milliseconds(100));
+            }
+        }
+
+        if (m_stopping)
+        {
+            return;
+        }
+
+        std::pop_heap(m_jobs.begin(), m_jobs.end(), JobOrder());
+
+        auto job = std::move(m_jobs.back());
+        m_jobs.pop_back();
+
+        ++m_running;
+
+        lock.unlock();
+
+        // Deadline could pass after last check
+        // of deadline thread
+        if (Clock::now() > job.deadline)
+        {
+            job.promise->set_exception(
+                std::make_exception_ptr(std::runtime_error("Build deadline exceeded"))
+            );
+        }
+        else
+        {
+            try
+            {
+                auto start = Clock::now();
+
+                auto library = job.builder->build(m_compileSlots);
+
+                record(job.fingerprint, Clock::now() - start);
+
+                job.promise->set_value(std::move(library));
+            }
+            catch (...)
+            {
+                job.promise->set_exception(std::current_exception());
+            }
+        }
+
+        lock.lock();
+
+        --m_running;
+
+        lock.unlock();
+
+        m_condition.notify_all();
+    }
+}
+
+void CodeExecutor::BuildService::expire()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (!m_stopping)
+    {
+        auto now = Clock::now();
+
+        auto expired = std::partition(
+            m_jobs.begin(),
+            m_jobs.end(),
+            [now](const Job& job)
+            {
+                return job.deadline >= now;
+            }
+        );
+
+        if (expired != m_jobs.end())
+        {
+            std::vector<Job> jobs(
+                std::make_move_iterator(expired),
+                std::make_move_iterator(m_jobs.end())
+            );
+
+            m_jobs.erase(expired, m_jobs.end());
+
+            std::make_heap(m_jobs.begin(), m_jobs.end(), JobOrder());
+
+            // Promises are not fulfilled under lock,
+            // waiters may submit next jobs right away
+            lock.unlock();
+
+            for (auto&& job : jobs)
+            {
+                job.promise->set_exception(
+                    std::make_exception_ptr(std::runtime_error("Build deadline exceeded"))
+                );
+            }
+
+            lock.lock();
+
+            continue;
+        }
+
+        auto next = Clock::time_point::max();
+
+        for (auto&& job : m_jobs)
+        {
+            next = std::min(next, job.deadline);
+        }
+
+        if (next == Clock::time_point::max())
+        {
+            m_deadlineCondition.wait(lock);
+        }
+        else
+        {
+            m_deadlineCondition.wait_until(lock, next);
+        }
+    }
+}
+
+bool CodeExecutor::BuildService::canStart() const
+{
+    if (m_running == 0)
+    {
+        return true;
+    }
+
+    // Just started builds have not allocated their
+    // memory yet, so it's reserved for every running one
+    auto available = availableMemory();
+    auto reserved = m_running * m_memoryPerBuild;
+
+    return available >= reserved &&
+           available - reserved >= m_memoryPerBuild;
+}
+
+void CodeExecutor::BuildService::record(const std::string& fingerprint,
+                                        Clock::duration duration)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto history = m_historyIndex.find(fingerprint);
+
+    if (history != m_historyIndex.end())
+    {
+        m_history.splice(m_history.begin(), m_history, history->second);
+
+        // Exponential moving average smooths out
+        // single slow or fast runs
+        auto& expected = history->second->second;
+        expected += (duration - expected) * 3 / 10;
+
+        return;
+    }
+
+    if (m_historySize == 0)
+    {
+        return;
+    }
+
+    if (m_history.size() >= m_historySize)
+    {
+        m_historyIndex.erase(m_history.back().first);
+        m_history.pop_back();
+    }
+
+    m_history.emplace_front(fingerprint, duration);
+    m_historyIndex[fingerprint] = m_history.begin();
+}
+
+std::uint64_t CodeExecutor::BuildService::availableMemory()
+{
+    std::ifstream meminfo("/proc/meminfo");
+
+    std::string key;
+    std::uint64_t value;
+    std::string unit;
+
+    while (meminfo >> key >> value >> unit)
+    {
+        if (key == "MemAvailable:")
+        {
+            return value * 1024;
+        }
+    }
+
+    // Free memory is a lower bound of available one
+    return static_cast<std::uint64_t>(sysconf(_SC_AVPHYS_PAGES)) *
+           static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+}
@@ -1,11 +1,35 @@
 #include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
 #include "CodeExecutor/Builder.hpp"
+#include "CodeExecutor/Sha256.hpp"
+#include "CodeExecutor/UnityBatcher.hpp"
+#include "CodeExecutor/Workspace.hpp"
+
+static unsigned int hardwareJobs()
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
 
 CodeExecutor::Builder::Builder() :
     m_compiler(nullptr),
     m_linker(nullptr),
     m_targets(),
-    m_context()
+    m_context(),
+    m_jobs(hardwareJobs()),
+    m_libraryCache(),
+    m_executor(),
+    m_storage(std::make_shared<Workspace>()),
+    m_fastCompiler(),
+    m_optimizationFlag("-O2"),
+    m_incremental(false),
+    m_unityBuild(false),
+    m_unityBatchSize(8),
+    m_stateMutex(),
+    m_builtObjects(),
+    m_builtContext(),
+    m_rebuiltTargets()
 {
 
 }
@@ -37,9 +61,13 @@ void CodeExecutor::Builder::clearTargets()
 
 void CodeExecutor::Builder::addTarget(CodeExecutor::SourcePtr source)
 {
+    // Fingerprint is strong, so different sources
+    // never share object name
+    auto objectName = source->fingerprint();
+
     m_targets.emplace_back(
-        source,
-       std::to_string(m_hash(source->content()))
+        std::move(source),
+        std::move(objectName)
     );
 }
 
@@ -111,7 +139,381 @@ CodeExecutor::BuildingContextPtr CodeExecutor::Builder::buildingContext() const
     return m_context;
 }
 
+void CodeExecutor::Builder::setJobs(unsigned int jobs)
+{
+    m_jobs = jobs == 0 ? hardwareJobs() : jobs;
+}
+
+unsigned int CodeExecutor::Builder::jobs() const
+{
+    return m_jobs;
+}
+
+void CodeExecutor::Builder::setLibraryCache(CodeExecutor::LibraryCachePtr cache)
+{
+    m_libraryCache = std::move(cache);
+}
+
+CodeExecutor::LibraryCachePtr CodeExecutor::Builder::libraryCache() const
+{
+    return m_libraryCache;
+}
+
+std::string CodeExecutor::Builder::fingerprint() const
+{
+    if (m_compiler == nullptr)
+    {
+        throw std::runtime_error("No compiler specified");
+    }
+
+    Sha256 sha;
+
+    sha.update(contextFingerprint(m_context));
+
+    for (auto&& target : m_targets)
+    {
+        sha.update(target.first->fingerprint());
+    }
+
+    return sha.hexDigest();
+}
+
+void CodeExecutor::Builder::setIncremental(bool incremental)
+{
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+
+    m_incremental = incremental;
+
+    if (!m_incremental)
+    {
+        m_builtObjects.clear();
+        m_builtContext.clear();
+    }
+}
+
+bool CodeExecutor::Builder::isIncremental() const
+{
+    return m_incremental;
+}
+
+std::vector<std::filesystem::path> CodeExecutor::Builder::rebuiltTargets() const
+{
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+
+    return m_rebuiltTargets;
+}
+
+std::future<CodeExecutor::LibraryPtr> CodeExecutor::Builder::buildAsync() const
+{
+    auto promise = std::make_shared<std::promise<LibraryPtr>>();
+    auto future = promise->get_future();
+
+    buildAsync(
+        [promise](LibraryPtr library, std::exception_ptr error)
+        {
+            if (error)
+            {
+                promise->set_exception(std::move(error));
+            }
+            else
+            {
+                promise->set_value(std::move(library));
+            }
+        }
+    );
+
+    return future;
+}
+
+void CodeExecutor::Builder::buildAsync(BuildCallback callback) const
+{
+    executor()->post(
+        [this, callback = std::move(callback)]()
+        {
+            LibraryPtr library;
+            std::exception_ptr error;
+
+            try
+            {
+                library = build();
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+
+            callback(std::move(library), std::move(error));
+        }
+    );
+}
+
+CodeExecutor::TieredLibraryPtr CodeExecutor::Builder::buildTiered() const
+{
+    if (m_compiler == nullptr)
+    {
+        throw std::runtime_error("No compiler specified");
+    }
+
+    auto fast = makeTierBuilder(
+        m_fastCompiler ? m_fastCompiler : m_compiler,
+        "-O0",
+        "_fast"
+    );
+
+    auto library = std::make_shared<TieredLibrary>(fast->build());
+
+    auto optimized = makeTierBuilder(
+        m_compiler,
+        m_optimizationFlag,
+        "_optimized"
+    );
+
+    // Dropped tiered library is not optimized
+    std::weak_ptr<TieredLibrary> weakLibrary = library;
+
+    optimized->buildAsync(
+        [optimized, weakLibrary](LibraryPtr result, std::exception_ptr error)
+        {
+            auto library = weakLibrary.lock();
+
+            if (library == nullptr)
+            {
+                return;
+            }
+
+            if (error)
+            {
+                library->fail(std::move(error));
+            }
+            else
+            {
+                library->promote(std::move(result));
+            }
+        }
+    );
+
+    return library;
+}
+
+void CodeExecutor::Builder::setFastCompiler(CodeExecutor::CompilerPtr compiler)
+{
+    m_fastCompiler = std::move(compiler);
+}
+
+CodeExecutor::CompilerPtr CodeExecutor::Builder::fastCompiler() const
+{
+    return m_fastCompiler;
+}
+
+void CodeExecutor::Builder::setOptimizationFlag(std::string flag)
+{
+    m_optimizationFlag = std::move(flag);
+}
+
+std::string CodeExecutor::Builder::optimizationFlag() const
+{
+    return m_optimizationFlag;
+}
+
+CodeExecutor::BuilderPtr CodeExecutor::Builder::makeTierBuilder(CodeExecutor::CompilerPtr compiler,
+                                                                const std::string& flag,
+                                                                const std::string& suffix) const
+{
+    auto builder = std::make_shared<Builder>();
+
+    builder->setCompiler(std::move(compiler));
+    builder->setLinker(m_linker);
+    builder->setJobs(m_jobs);
+    builder->setExecutor(m_executor);
+    builder->setStorage(m_storage);
+    builder->setUnityBuild(m_unityBuild);
+    builder->setUnityBatchSize(m_unityBatchSize);
+
+    auto context = m_context ?
+        std::make_shared<BuildingContext>(*m_context) :
+        std::make_shared<BuildingContext>();
+
+    // The last optimization flag is used by compiler
+    context->addCompileFlag(flag);
+
+    builder->setBuildingContext(context);
+
+    // Tiers have own objects, so they
+    // can be built at the same time
+    for (auto&& target : m_targets)
+    {
+        auto objectName = target.second;
+        objectName += suffix;
+
+        builder->addTarget(target.first, objectName);
+    }
+
+    return builder;
+}
+
+void CodeExecutor::Builder::setExecutor(CodeExecutor::ExecutorPtr executor)
+{
+    m_executor = std::move(executor);
+}
+
+CodeExecutor::ExecutorPtr CodeExecutor::Builder::executor() const
+{
+    return m_executor ? m_executor : Executor::global();
+}
+
+void CodeExecutor::Builder::setStorage(CodeExecutor::ArtifactStoragePtr storage)
+{
+    m_storage = std::move(storage);
+}
+
+CodeExecutor::ArtifactStoragePtr CodeExecutor::Builder::storage() const
+{
+    return m_storage;
+}
+
+std::string CodeExecutor::Builder::contextFingerprint(const BuildingContextPtr& context) const
+{
+    Sha256 sha;
+
+    // Every part is terminated with zero byte,
+    // so different splits give different fingerprints
+    sha.update(m_compiler->identity());
+    sha.update("", 1);
+
+    if (context)
+    {
+        sha.update(context->fingerprint());
+    }
+
+    return sha.hexDigest();
+}
+
+CodeExecutor::BuildingContextPtr CodeExecutor::Builder::effectiveContext() const
+{
+    if (m_context == nullptr ||
+        !m_context->isAutomaticPrecompiledHeader() ||
+        !m_context->precompiledHeader().empty())
+    {
+        return m_context;
+    }
+
+    std::vector<SourcePtr> sources;
+
+    for (auto&& target : m_targets)
+    {
+        sources.push_back(target.first);
+    }
+
+    auto header = commonIncludePrefix(sources);
+
+    if (header.empty())
+    {
+        return m_context;
+    }
+
+    auto context = std::make_shared<BuildingContext>(*m_context);
+
+    context->setPrecompiledHeader(std::move(header));
+
+    return context;
+}
+
+std::string CodeExecutor::Builder::commonIncludePrefix(const std::vector<SourcePtr>& sources)
+{
+    std::vector<std::string> prefix;
+    bool first = true;
+
+    for (auto&& source : sources)
+    {
+        // Leading `#include` lines. Empty lines
+        // and line comments are skipped
+        std::vector<std::string> includes;
+
+        // Only leading lines are scanned, content
+        // is not copied
+        auto content = source->contentView();
+
+        while (!content.empty())
+        {
+            auto end = content.find('\n');
+            auto line = content.substr(0, end);
+
+            content.remove_prefix(end == std::string_view::npos ? content.size() : end + 1);
+
+            auto begin = line.find_first_not_of(" \t\r");
+
+            if (begin == std::string::npos ||
+                line.compare(begin, 2, "//") == 0)
+            {
+                continue;
+            }
+
+            auto directive = line.find_first_not_of(" \t", begin + 1);
+
+            if (line[begin] != '#' ||
+                directive == std::string::npos ||
+                line.compare(directive, 7, "include") != 0)
+            {
+                break;
+            }
+
+            includes.emplace_back(line.substr(begin));
+        }
+
+        if (first)
+        {
+            prefix = std::move(includes);
+            first = false;
+            continue;
+        }
+
+        auto mismatch = std::mismatch(
+            prefix.begin(),
+            prefix.end(),
+            includes.begin(),
+            includes.end()
+        );
+
+        prefix.erase(mismatch.first, prefix.end());
+    }
+
+    std::string header;
+
+    for (auto&& include : prefix)
+    {
+        header += include;
+        header += '\n';
+    }
+
+    return header;
+}
+
+void CodeExecutor::Builder::setUnityBuild(bool unityBuild)
+{
+    m_unityBuild = unityBuild;
+}
+
+bool CodeExecutor::Builder::isUnityBuild() const
+{
+    return m_unityBuild;
+}
+
+void CodeExecutor::Builder::setUnityBatchSize(std::size_t batchSize)
+{
+    m_unityBatchSize = std::max<std::size_t>(batchSize, 1);
+}
+
+std::size_t CodeExecutor::Builder::unityBatchSize() const
+{
+    return m_unityBatchSize;
+}
+
 CodeExecutor::LibraryPtr CodeExecutor::Builder::build() const
+{
+    return build(nullptr);
+}
+
+CodeExecutor::LibraryPtr CodeExecutor::Builder::build(const CompileSlotsPtr& slots) const
 {
     if (m_compiler == nullptr)
     {
@@ -123,16 +525,300 @@ CodeExecutor::LibraryPtr CodeExecutor::Builder::build() const
         throw std::runtime_error("No linker specified");
     }
 
-    std::vector<ObjectPtr> objects;
+    if (m_libraryCache)
+    {
+        return m_libraryCache->get(
+            fingerprint(),
+            [this, &slots]()
+            {
+                return m_linker->link(compileTargets(slots), m_storage);
+            }
+        );
+    }
+
+    return m_linker->link(compileTargets(slots), m_storage);
+}
+
+void CodeExecutor::Builder::makeUnits(TargetsContainer& units,
+                                      UnitMembersContainer& members) const
+{
+    units.clear();
+    members.clear();
+
+    if (!m_unityBuild)
+    {
+        units = m_targets;
+
+        for (auto&& target : m_targets)
+        {
+            members.push_back({target.second});
+        }
+
+        return;
+    }
+
+    std::vector<SourcePtr> sources;
 
     for (auto&& target : m_targets)
     {
-        objects.push_back(m_compiler->compile(
-            target.first,
-            target.second,
-            m_context
-        ));
+        sources.push_back(target.first);
+    }
+
+    for (auto&& batch : UnityBatcher(m_unityBatchSize).batch(sources))
+    {
+        // Single source is compiled as is
+        if (batch.size() == 1)
+        {
+            units.push_back(m_targets[batch.front()]);
+            members.push_back({m_targets[batch.front()].second});
+            continue;
+        }
+
+        std::vector<SourcePtr> batchSources;
+        std::vector<std::string> batchNames;
+        std::vector<std::filesystem::path> batchMembers;
+
+        for (auto i : batch)
+        {
+            batchSources.push_back(m_targets[i].first);
+            batchNames.push_back(m_targets[i].second.string());
+            batchMembers.push_back(m_targets[i].second);
+        }
+
+        auto source = UnityBatcher::merge(batchSources, batchNames);
+
+        units.emplace_back(
+            source,
+            "unity_" + source->fingerprint()
+        );
+
+        members.push_back(std::move(batchMembers));
+    }
+}
+
+std::vector<CodeExecutor::ObjectPtr> CodeExecutor::Builder::compileTargets(const CompileSlotsPtr& slots) const
+{
+    TargetsContainer units;
+    UnitMembersContainer members;
+
+    makeUnits(units, members);
+
+    auto context = effectiveContext();
+
+    std::vector<ObjectPtr> objects(units.size());
+    std::vector<TargetsContainer::size_type> pending;
+
+    if (!m_incremental)
+    {
+        for (TargetsContainer::size_type i = 0; i < units.size(); ++i)
+        {
+            pending.push_back(i);
+        }
+
+        compile(units, context, pending, objects, slots);
+
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+
+        m_rebuiltTargets.clear();
+
+        for (auto&& target : m_targets)
+        {
+            m_rebuiltTargets.push_back(target.second);
+        }
+
+        return objects;
+    }
+
+    // State is locked for the whole build, so
+    // incremental builds of one builder are serialized
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+
+    auto contextHash = contextFingerprint(context);
+
+    // Every object depends on context
+    if (contextHash != m_builtContext)
+    {
+        m_builtObjects.clear();
+        m_builtContext = contextHash;
+    }
+
+    std::vector<std::string> contentHashes(units.size());
+
+    for (TargetsContainer::size_type i = 0; i < units.size(); ++i)
+    {
+        contentHashes[i] = units[i].first->fingerprint();
+
+        auto built = m_builtObjects.find(units[i].second.string());
+
+        std::error_code error;
+
+        if (built != m_builtObjects.end() &&
+            built->second.contentHash == contentHashes[i] &&
+            std::filesystem::exists(built->second.object->path(), error))
+        {
+            objects[i] = built->second.object;
+        }
+        else
+        {
+            pending.push_back(i);
+        }
+    }
+
+    compile(units, context, pending, objects, slots);
+
+    // Removed targets are forgotten
+    BuiltObjectsContainer builtObjects;
+
+    for (TargetsContainer::size_type i = 0; i < units.size(); ++i)
+    {
+        builtObjects[units[i].second.string()] = {contentHashes[i], objects[i]};
+    }
+
+    m_builtObjects = std::move(builtObjects);
+
+    m_rebuiltTargets.clear();
+
+    for (auto i : pending)
+    {
+        m_rebuiltTargets.insert(
+            m_rebuiltTargets.end(),
+            members[i].begin(),
+            members[i].end()
+        );
+    }
+
+    return objects;
+}
+
+void CodeExecutor::Builder::compile(const TargetsContainer& units,
+                                    const BuildingContextPtr& context,
+                                    const std::vector<TargetsContainer::size_type>& indices,
+                                    std::vector<ObjectPtr>& objects,
+                                    const CompileSlotsPtr& slots) const
+{
+    auto compileObject = [&](TargetsContainer::size_type i)
+    {
+        if (!m_storage)
+        {
+            return m_compiler->compile(
+                units[i].first,
+                units[i].second,
+                context
+            );
+        }
+
+        // Compiler writes to artifact path, object
+        // keeps artifact alive
+        auto artifact = m_storage->create(units[i].second.filename().string());
+
+        auto object = m_compiler->compile(
+            units[i].first,
+            artifact->path(),
+            context
+        );
+
+        return std::make_shared<Object>(
+            std::move(artifact),
+            object->standardOutput(),
+            object->standardError()
+        );
+    };
+
+    // Slot is taken by compilation only, so
+    // builds never hold it while waiting
+    auto compileUnit = [&](TargetsContainer::size_type i)
+    {
+        if (!slots)
+        {
+            return compileObject(i);
+        }
+
+        slots->acquire();
+
+        try
+        {
+            auto object = compileObject(i);
+
+            slots->release();
+
+            return object;
+        }
+        catch (...)
+        {
+            slots->release();
+
+            throw;
+        }
+    };
+
+    auto workers = std::min<TargetsContainer::size_type>(m_jobs, indices.size());
+
+    if (workers <= 1)
+    {
+        for (auto i : indices)
+        {
+            objects[i] = compileUnit(i);
+        }
+
+        return;
+    }
+
+    std::atomic<TargetsContainer::size_type> next(0);
+    std::atomic_bool failed(false);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    // Every worker takes next not compiled target
+    // until targets are over or someone fails
+    auto worker = [&]()
+    {
+        while (!failed)
+        {
+            auto n = next++;
+
+            if (n >= indices.size())
+            {
+                return;
+            }
+
+            auto i = indices[n];
+
+            try
+            {
+                objects[i] = compileUnit(i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(errorMutex);
+
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+
+                failed = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+
+    for (decltype(workers) i = 1; i < workers; ++i)
+    {
+        threads.emplace_back(worker);
     }
 
-    return m_linker->link(objects);
+    // Current thread is a worker too
+    worker();
+
+    for (auto&& thread : threads)
+    {
+        thread.join();
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
 }
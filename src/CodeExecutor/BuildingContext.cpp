@@ -1,11 +1,14 @@
 #include "CodeExecutor/BuildingContext.hpp"
+#include "CodeExecutor/Sha256.hpp"
 
 CodeExecutor::BuildingContext::BuildingContext() :
     m_includeDirectories(),
     m_libraryDirectories(),
     m_libraries(),
     m_compileFlags(),
-    m_defines()
+    m_defines(),
+    m_precompiledHeader(),
+    m_automaticPrecompiledHeader(false)
 {
 
 }
@@ -218,3 +221,75 @@ CodeExecutor::BuildingContext::defineAt(const CodeExecutor::BuildingContext::Def
 {
     return m_defines.at(index);
 }
+
+CodeExecutor::BuildingContext::ArgumentsContainer
+CodeExecutor::BuildingContext::compileArguments() const
+{
+    ArgumentsContainer arguments;
+
+    for (auto&& directory : m_includeDirectories)
+    {
+        arguments.push_back("-I" + directory.string());
+    }
+
+    for (auto&& directory : m_libraryDirectories)
+    {
+        arguments.push_back("-L" + directory.string());
+    }
+
+    for (auto&& library : m_libraries)
+    {
+        arguments.push_back("-l" + library);
+    }
+
+    for (auto&& define : m_defines)
+    {
+        arguments.push_back("-D" + define);
+    }
+
+    arguments.insert(
+        arguments.end(),
+        m_compileFlags.begin(),
+        m_compileFlags.end()
+    );
+
+    return arguments;
+}
+
+void CodeExecutor::BuildingContext::setPrecompiledHeader(std::string content)
+{
+    m_precompiledHeader = std::move(content);
+}
+
+const std::string& CodeExecutor::BuildingContext::precompiledHeader() const
+{
+    return m_precompiledHeader;
+}
+
+void CodeExecutor::BuildingContext::setAutomaticPrecompiledHeader(bool automatic)
+{
+    m_automaticPrecompiledHeader = automatic;
+}
+
+bool CodeExecutor::BuildingContext::isAutomaticPrecompiledHeader() const
+{
+    return m_automaticPrecompiledHeader;
+}
+
+std::string CodeExecutor::BuildingContext::fingerprint() const
+{
+    Sha256 sha;
+
+    // Every part is terminated with zero byte,
+    // so different splits give different fingerprints
+    for (auto&& argument : compileArguments())
+    {
+        sha.update(argument);
+        sha.update("", 1);
+    }
+
+    sha.update("", 1);
+    sha.update(m_precompiledHeader);
+
+    return sha.hexDigest();
+}
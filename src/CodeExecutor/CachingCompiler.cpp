@@ -0,0 +1,299 @@
+#include <algorithm>
+#include <unistd.h>
+#include "CodeExecutor/CachingCompiler.hpp"
+#include "CodeExecutor/Sha256.hpp"
+
+static const char* objectExtension = ".o";
+
+CodeExecutor::CachingCompiler::CachingCompiler(CodeExecutor::CompilerPtr compiler,
+                                               std::filesystem::path directory,
+                                               std::uintmax_t sizeBudget) :
+    m_compiler(std::move(compiler)),
+    m_directory(std::move(directory)),
+    m_sizeBudget(sizeBudget),
+    m_mutex(),
+    m_entries(),
+    m_index(),
+    m_size(0),
+    m_hits(0),
+    m_misses(0)
+{
+    if (m_compiler == nullptr)
+    {
+        throw std::invalid_argument("No compiler specified");
+    }
+
+    std::filesystem::create_directories(m_directory);
+
+    loadIndex();
+}
+
+CodeExecutor::ObjectPtr
+CodeExecutor::CachingCompiler::compile(CodeExecutor::SourcePtr source,
+                                       const std::filesystem::path& output,
+                                       CodeExecutor::BuildingContextPtr buildingContext)
+{
+    auto objectKey = key(source, buildingContext);
+
+    if (restore(objectKey, output))
+    {
+        ++m_hits;
+
+        return std::make_shared<Object>(output);
+    }
+
+    ++m_misses;
+
+    auto object = m_compiler->compile(
+        std::move(source),
+        output,
+        std::move(buildingContext)
+    );
+
+    store(objectKey, object->path());
+
+    return object;
+}
+
+std::string CodeExecutor::CachingCompiler::identity() const
+{
+    return m_compiler->identity();
+}
+
+CodeExecutor::CompilerPtr CodeExecutor::CachingCompiler::compiler() const
+{
+    return m_compiler;
+}
+
+std::filesystem::path CodeExecutor::CachingCompiler::directory() const
+{
+    return m_directory;
+}
+
+std::uintmax_t CodeExecutor::CachingCompiler::sizeBudget() const
+{
+    return m_sizeBudget;
+}
+
+std::uintmax_t CodeExecutor::CachingCompiler::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_size;
+}
+
+std::uint64_t CodeExecutor::CachingCompiler::hits() const
+{
+    return m_hits;
+}
+
+std::uint64_t CodeExecutor::CachingCompiler::misses() const
+{
+    return m_misses;
+}
+
+std::string CodeExecutor::CachingCompiler::key(const CodeExecutor::SourcePtr& source,
+                                               const CodeExecutor::BuildingContextPtr& buildingContext) const
+{
+    Sha256 sha;
+
+    // Every part is terminated with zero byte,
+    // so different splits give different keys
+    sha.update(m_compiler->identity());
+    sha.update("", 1);
+
+    if (buildingContext)
+    {
+        sha.update(buildingContext->fingerprint());
+    }
+
+    sha.update("", 1);
+    sha.update(source->fingerprint());
+
+    return sha.hexDigest();
+}
+
+void CodeExecutor::CachingCompiler::loadIndex()
+{
+    struct Found
+    {
+        std::filesystem::file_time_type lastUse;
+        Entry entry;
+    };
+
+    std::vector<Found> found;
+
+    for (auto&& item : std::filesystem::directory_iterator(m_directory))
+    {
+        if (!std::filesystem::is_regular_file(item.status()) ||
+            item.path().extension() != objectExtension)
+        {
+            continue;
+        }
+
+        std::error_code error;
+
+        auto size = std::filesystem::file_size(item.path(), error);
+        auto lastUse = std::filesystem::last_write_time(item.path(), error);
+
+        if (error)
+        {
+            continue;
+        }
+
+        found.push_back({lastUse, {item.path().stem().string(), size}});
+    }
+
+    std::sort(
+        found.begin(),
+        found.end(),
+        [](const Found& lhs, const Found& rhs)
+        {
+            return lhs.lastUse > rhs.lastUse;
+        }
+    );
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto&& item : found)
+    {
+        m_entries.push_back(item.entry);
+        m_index[item.entry.key] = std::prev(m_entries.end());
+        m_size += item.entry.size;
+    }
+
+    evict();
+}
+
+std::filesystem::path CodeExecutor::CachingCompiler::entryPath(const std::string& key) const
+{
+    return m_directory / (key + objectExtension);
+}
+
+bool CodeExecutor::CachingCompiler::restore(const std::string& key,
+                                            const std::filesystem::path& output)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto entry = m_index.find(key);
+
+        if (entry == m_index.end())
+        {
+            return false;
+        }
+
+        m_entries.splice(m_entries.begin(), m_entries, entry->second);
+    }
+
+    // Object is copied without lock, so hits of
+    // parallel compilations are not serialized
+    auto path = entryPath(key);
+
+    std::error_code error;
+
+    std::filesystem::copy_file(
+        path,
+        output,
+        std::filesystem::copy_options::overwrite_existing,
+        error
+    );
+
+    // Object could be evicted by other thread or
+    // removed by other process, that shares cache
+    // directory
+    if (error)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto entry = m_index.find(key);
+
+        if (entry != m_index.end())
+        {
+            m_size -= entry->second->size;
+            m_entries.erase(entry->second);
+            m_index.erase(entry);
+        }
+
+        return false;
+    }
+
+    // Modification time is used as last use time
+    // when index is loaded by next run
+    std::filesystem::last_write_time(
+        path,
+        std::filesystem::file_time_type::clock::now(),
+        error
+    );
+
+    return true;
+}
+
+void CodeExecutor::CachingCompiler::store(const std::string& key,
+                                          const std::filesystem::path& object)
+{
+    static std::atomic<std::uint64_t> counter(0);
+
+    auto path = entryPath(key);
+
+    // Object is copied to temporary file first and then
+    // renamed, so other processes never see partial object
+    auto temporary = path;
+    temporary += "." + std::to_string(getpid()) +
+                 "." + std::to_string(++counter) + ".tmp";
+
+    std::error_code error;
+
+    std::filesystem::copy_file(object, temporary, error);
+
+    if (!error)
+    {
+        std::filesystem::rename(temporary, path, error);
+    }
+
+    if (error)
+    {
+        std::filesystem::remove(temporary, error);
+        return;
+    }
+
+    auto size = std::filesystem::file_size(path, error);
+
+    if (error)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto entry = m_index.find(key);
+
+    // Same object could be stored by parallel compilation
+    if (entry != m_index.end())
+    {
+        m_size -= entry->second->size;
+        m_entries.erase(entry->second);
+        m_index.erase(entry);
+    }
+
+    m_entries.push_front({key, size});
+    m_index[key] = m_entries.begin();
+    m_size += size;
+
+    evict();
+}
+
+void CodeExecutor::CachingCompiler::evict()
+{
+    while (m_size > m_sizeBudget && !m_entries.empty())
+    {
+        auto& entry = m_entries.back();
+
+        std::error_code error;
+        std::filesystem::remove(entryPath(entry.key), error);
+
+        m_size -= entry.size;
+        m_index.erase(entry.key);
+        m_entries.pop_back();
+    }
+}
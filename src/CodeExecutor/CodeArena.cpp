@@ -0,0 +1,157 @@
+#include <iterator>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "CodeExecutor/CodeArena.hpp"
+
+static std::size_t alignUp(std::size_t value, std::size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+CodeExecutor::CodeArena::CodeArena(std::size_t size) :
+    m_base(nullptr),
+    m_size(alignUp(size, pageSize())),
+    m_mutex(),
+    m_free(),
+    m_used(0)
+{
+    auto base = mmap(
+        nullptr,
+        m_size,
+        PROT_NONE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+        -1,
+        0
+    );
+
+    if (base == MAP_FAILED)
+    {
+        throw std::runtime_error("Can't reserve code arena");
+    }
+
+    m_base = static_cast<char*>(base);
+    m_free.emplace(0, m_size);
+}
+
+CodeExecutor::CodeArena::~CodeArena()
+{
+    munmap(m_base, m_size);
+}
+
+void* CodeExecutor::CodeArena::allocate(std::size_t size, std::size_t alignment)
+{
+    auto page = pageSize();
+
+    size = alignUp(size, page);
+    alignment = alignment > page ? alignment : page;
+
+    if (size == 0)
+    {
+        return nullptr;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    // First fit keeps blocks packed at arena
+    // start, so few pages stay committed
+    for (auto range = m_free.begin(); range != m_free.end(); ++range)
+    {
+        auto begin = range->first;
+        auto end = range->first + range->second;
+
+        auto offset = alignUp(reinterpret_cast<std::size_t>(m_base) + begin, alignment) -
+                      reinterpret_cast<std::size_t>(m_base);
+
+        if (offset + size > end)
+        {
+            continue;
+        }
+
+        m_free.erase(range);
+
+        if (offset > begin)
+        {
+            m_free.emplace(begin, offset - begin);
+        }
+
+        if (offset + size < end)
+        {
+            m_free.emplace(offset + size, end - offset - size);
+        }
+
+        m_used += size;
+
+        lock.unlock();
+
+        auto block = m_base + offset;
+
+        if (mprotect(block, size, PROT_READ | PROT_WRITE) != 0)
+        {
+            release(block, size);
+            return nullptr;
+        }
+
+        return block;
+    }
+
+    return nullptr;
+}
+
+void CodeExecutor::CodeArena::release(void* block, std::size_t size)
+{
+    size = alignUp(size, pageSize());
+
+    auto pointer = static_cast<char*>(block);
+
+    // Pages are freed and become zero on next use
+    madvise(pointer, size, MADV_DONTNEED);
+    mprotect(pointer, size, PROT_NONE);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto offset = static_cast<std::size_t>(pointer - m_base);
+
+    auto inserted = m_free.emplace(offset, size).first;
+
+    // Neighbour ranges are merged
+    auto next = std::next(inserted);
+
+    if (next != m_free.end() && inserted->first + inserted->second == next->first)
+    {
+        inserted->second += next->second;
+        m_free.erase(next);
+    }
+
+    if (inserted != m_free.begin())
+    {
+        auto previous = std::prev(inserted);
+
+        if (previous->first + previous->second == inserted->first)
+        {
+            previous->second += inserted->second;
+            m_free.erase(inserted);
+        }
+    }
+
+    m_used -= size;
+}
+
+std::size_t CodeExecutor::CodeArena::size() const
+{
+    return m_size;
+}
+
+std::size_t CodeExecutor::CodeArena::used() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_used;
+}
+
+std::size_t CodeExecutor::CodeArena::pageSize()
+{
+    static auto size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+
+    return size;
+}
@@ -1,11 +1,47 @@
+#include <atomic>
+#include <fstream>
+#include <unistd.h>
 #include "CodeExecutor/CommonCompiler.hpp"
+#include "CodeExecutor/Sha256.hpp"
+
+static const char* headerName = "header.hpp";
+static const char* precompiledHeaderName = "header.hpp.gch";
+
+// Counter separates concurrent precompilations
+// of one process, process id separates processes
+static std::atomic<unsigned long long> temporaryCounter(0);
 
 CodeExecutor::CommonCompiler::CommonCompiler(std::filesystem::path pathToCompiler) :
-    m_path(std::move(pathToCompiler))
+    m_path(std::move(pathToCompiler)),
+    m_mutex(),
+    m_headersDirectory(std::filesystem::temp_directory_path() / "CodeExecutorPCH"),
+    m_headers()
 {
 
 }
 
+std::string CodeExecutor::CommonCompiler::identity() const
+{
+    std::error_code error;
+
+    auto binary = std::filesystem::canonical(m_path, error);
+
+    if (error)
+    {
+        return m_path.string();
+    }
+
+    // Binary is identified by it's location, size and
+    // modification time, so compiler updates invalidate
+    // identity.
+    auto size = std::filesystem::file_size(binary, error);
+    auto modified = std::filesystem::last_write_time(binary, error);
+
+    return binary.string() + ':' +
+           std::to_string(size) + ':' +
+           std::to_string(modified.time_since_epoch().count());
+}
+
 CodeExecutor::ObjectPtr
 CodeExecutor::CommonCompiler::compile(CodeExecutor::SourcePtr source,
                                       const std::filesystem::path& output,
@@ -17,48 +53,23 @@ CodeExecutor::CommonCompiler::compile(CodeExecutor::SourcePtr source,
 
     if (buildingContext)
     {
-        for (auto iterator = buildingContext->includeDirectoriesBegin(),
-                  end = buildingContext->includeDirectoriesEnd();
-             iterator != end;
-             ++iterator)
-        {
-            arguments.push_back(" -I" + iterator->string());
-        }
+        arguments = buildingContext->compileArguments();
 
-        for (auto iterator = buildingContext->libraryDirectoriesBegin(),
-                  end = buildingContext->libraryDirectoriesEnd();
-             iterator != end;
-             ++iterator)
+        // `gcc` uses `header.hpp.gch` instead of
+        // included `header.hpp` if it's near it
+        if (!buildingContext->precompiledHeader().empty())
         {
-            arguments.push_back(" -L" + iterator->string());
-        }
-
-        for (auto iterator = buildingContext->librariesBegin(),
-                  end = buildingContext->librariesEnd();
-             iterator != end;
-             ++iterator)
-        {
-            arguments.push_back(" -l" + *iterator);
-        }
-
-        for (auto iterator = buildingContext->definesBegin(),
-                  end = buildingContext->definesEnd();
-             iterator != end;
-             ++iterator)
-        {
-            arguments.push_back(" -D" + *iterator);
-        }
+            auto header = precompiledHeader(buildingContext, arguments);
 
-        for (auto iterator = buildingContext->compileFlagsBegin(),
-                  end = buildingContext->compileFlagsEnd();
-             iterator != end;
-             ++iterator)
-        {
-            arguments.push_back(*iterator);
+            arguments.push_back("-include");
+            arguments.push_back(header.string());
         }
     }
 
+    // Stages communicate with pipes
+    // instead of temporary files
     std::string tail[] = {
+        "-pipe",
         "-fPIC",
         "-o",
         output,
@@ -67,13 +78,12 @@ CodeExecutor::CommonCompiler::compile(CodeExecutor::SourcePtr source,
         "-"
     };
 
-    arguments.insert(arguments.end(), tail, tail + 6);
+    arguments.insert(arguments.end(), std::begin(tail), std::end(tail));
 
     process.setArguments(std::move(arguments));
 
-    process.setInputData(
-        source->content()
-    );
+    // Source buffer is shared with process
+    process.setInputBuffer(source->buffer());
 
     auto result = process.start();
 
@@ -82,8 +92,161 @@ CodeExecutor::CommonCompiler::compile(CodeExecutor::SourcePtr source,
         throw std::runtime_error("Can't compile source. Error: " + process.readStandardError());
     }
 
-    setError(std::move(process.readStandardError()));
-    setOutput(std::move(process.readStandardOutput()));
+    return std::make_shared<Object>(
+        output,
+        process.readStandardOutput(),
+        process.readStandardError()
+    );
+}
+
+void CodeExecutor::CommonCompiler::setPrecompiledHeadersDirectory(std::filesystem::path path)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_headersDirectory = std::move(path);
+}
+
+std::filesystem::path CodeExecutor::CommonCompiler::precompiledHeadersDirectory() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_headersDirectory;
+}
+
+std::filesystem::path
+CodeExecutor::CommonCompiler::precompiledHeader(const CodeExecutor::BuildingContextPtr& buildingContext,
+                                                const Process::ArgumentsContainer& arguments)
+{
+    auto& content = buildingContext->precompiledHeader();
+
+    Sha256 sha;
+
+    // Precompiled header is valid only for the
+    // same compiler and arguments
+    sha.update(identity());
+    sha.update("", 1);
+
+    for (auto&& argument : arguments)
+    {
+        sha.update(argument);
+        sha.update("", 1);
+    }
+
+    sha.update("", 1);
+    sha.update(content);
+
+    auto key = sha.hexDigest();
+
+    std::promise<void> promise;
+    std::shared_future<void> future;
+    std::filesystem::path directory;
+    bool owner = false;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        directory = m_headersDirectory / key;
+
+        auto header = m_headers.find(key);
+
+        if (header != m_headers.end())
+        {
+            future = header->second;
+        }
+        else
+        {
+            future = promise.get_future().share();
+            m_headers.emplace(key, future);
+            owner = true;
+        }
+    }
+
+    // Header is precompiled by other thread
+    if (!owner)
+    {
+        future.get();
+
+        return directory / headerName;
+    }
+
+    try
+    {
+        precompile(content, directory, arguments);
+
+        promise.set_value();
+    }
+    catch (...)
+    {
+        promise.set_exception(std::current_exception());
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_headers.erase(key);
+
+        throw;
+    }
+
+    return directory / headerName;
+}
+
+void CodeExecutor::CommonCompiler::precompile(const std::string& content,
+                                              const std::filesystem::path& directory,
+                                              const Process::ArgumentsContainer& arguments)
+{
+    auto header = directory / headerName;
+    auto precompiled = directory / precompiledHeaderName;
+
+    // Header could be precompiled by previous run
+    // or by other process
+    if (std::filesystem::exists(precompiled))
+    {
+        return;
+    }
+
+    std::filesystem::create_directories(directory);
+
+    // Files are written under temporary names and
+    // renamed, so other processes never see partial files
+    auto suffix = "." + std::to_string(getpid()) + "_" + std::to_string(++temporaryCounter) + ".tmp";
+
+    {
+        std::ofstream stream(header.string() + suffix, std::ios::binary);
+
+        stream << content;
+
+        if (!stream)
+        {
+            throw std::runtime_error("Can't write precompiled header source.");
+        }
+    }
+
+    std::filesystem::rename(header.string() + suffix, header);
+
+    Process process(m_path);
+
+    auto headerArguments = arguments;
+
+    std::string tail[] = {
+        "-fPIC",
+        "-o",
+        precompiled.string() + suffix,
+        "-xc++-header",
+        header.string()
+    };
+
+    headerArguments.insert(headerArguments.end(), tail, tail + 5);
+
+    process.setArguments(std::move(headerArguments));
+
+    auto result = process.start();
+
+    if (result != 0)
+    {
+        std::error_code error;
+        std::filesystem::remove(precompiled.string() + suffix, error);
+
+        throw std::runtime_error("Can't precompile header. Error: " + process.readStandardError());
+    }
 
-    return std::make_shared<Object>(output);
+    std::filesystem::rename(precompiled.string() + suffix, precompiled);
 }
@@ -1,15 +1,42 @@
+#include <atomic>
+#include <unistd.h>
 #include "CodeExecutor/CommonLinker.hpp"
 
+// Linkers of one process share counter and
+// process id separates processes, so libraries
+// in one directory never overwrite each other
+static std::atomic<unsigned long long> libraryCounter(0);
+
 CodeExecutor::CommonLinker::CommonLinker(std::filesystem::path path) :
-    m_path(std::move(path))
+    m_path(std::move(path)),
+    m_storage(),
+    m_loader()
 {
 
 }
 
 CodeExecutor::LibraryPtr CodeExecutor::CommonLinker::link(const std::vector<ObjectPtr>& objects)
+{
+    return link(objects, nullptr);
+}
+
+CodeExecutor::LibraryPtr CodeExecutor::CommonLinker::link(const std::vector<ObjectPtr>& objects,
+                                                          const ArtifactStoragePtr& storage)
 {
     std::stringstream library_name;
-    library_name << "exec_" << ++m_counter << ".so";
+    library_name << "exec_" << getpid() << "_" << ++libraryCounter << ".so";
+
+    // Own storage overrides storage of builder
+    auto& target = m_storage ? m_storage : storage;
+
+    ArtifactPtr artifact;
+    std::filesystem::path output = library_name.str();
+
+    if (target)
+    {
+        artifact = target->create(library_name.str());
+        output = artifact->path();
+    }
 
     Process process(m_path);
 
@@ -18,7 +45,7 @@ CodeExecutor::LibraryPtr CodeExecutor::CommonLinker::link(const std::vector<Obje
         "-fPIC",
         "-lc",
         "-o",
-        library_name.str()
+        output.string()
     };
 
     for (auto&& obj : objects)
@@ -35,7 +62,39 @@ CodeExecutor::LibraryPtr CodeExecutor::CommonLinker::link(const std::vector<Obje
         throw std::runtime_error("Can't perform linkage.");
     }
 
+    // Loader copies library, so artifact
+    // isn't needed after loading
+    if (m_loader)
+    {
+        return m_loader->load(artifact ? output : std::filesystem::current_path() / output);
+    }
+
+    if (artifact)
+    {
+        return std::make_shared<CodeExecutor::Library>(std::move(artifact));
+    }
+
     auto currentPath = std::filesystem::current_path() / library_name.str();
 
     return std::make_shared<CodeExecutor::Library>(currentPath);
 }
+
+void CodeExecutor::CommonLinker::setStorage(ArtifactStoragePtr storage)
+{
+    m_storage = std::move(storage);
+}
+
+CodeExecutor::ArtifactStoragePtr CodeExecutor::CommonLinker::storage() const
+{
+    return m_storage;
+}
+
+void CodeExecutor::CommonLinker::setLoader(ElfLoaderPtr loader)
+{
+    m_loader = std::move(loader);
+}
+
+CodeExecutor::ElfLoaderPtr CodeExecutor::CommonLinker::loader() const
+{
+    return m_loader;
+}
@@ -0,0 +1,53 @@
+#include <algorithm>
+#include <thread>
+#include "CodeExecutor/CompileSlots.hpp"
+
+CodeExecutor::CompileSlots::CompileSlots(unsigned int slots) :
+    m_mutex(),
+    m_condition(),
+    m_capacity(slots),
+    m_taken(0)
+{
+    if (m_capacity == 0)
+    {
+        m_capacity = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+void CodeExecutor::CompileSlots::acquire()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    m_condition.wait(
+        lock,
+        [this]()
+        {
+            return m_taken < m_capacity;
+        }
+    );
+
+    ++m_taken;
+}
+
+void CodeExecutor::CompileSlots::release()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        --m_taken;
+    }
+
+    m_condition.notify_one();
+}
+
+unsigned int CodeExecutor::CompileSlots::capacity() const
+{
+    return m_capacity;
+}
+
+unsigned int CodeExecutor::CompileSlots::taken() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_taken;
+}
@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "CodeExecutor/ControlGroup.hpp"
+
+CodeExecutor::ControlGroup::ControlGroup(std::filesystem::path path) :
+    m_path(std::move(path)),
+    m_created(false)
+{
+    if (mkdir(m_path.c_str(), 0755) == 0)
+    {
+        m_created = true;
+    }
+    else if (errno != EEXIST)
+    {
+        throw std::runtime_error("Can't create control group " + m_path.string());
+    }
+
+    if (!std::filesystem::exists(processesFile()))
+    {
+        throw std::runtime_error(m_path.string() + " is not cgroup v2 group");
+    }
+
+    // Parent may already have controllers enabled or
+    // they may be unavailable, then limits can't be set
+    auto controlFile = m_path.parent_path() / "cgroup.subtree_control";
+
+    for (auto controller : {"+cpu", "+memory"})
+    {
+        auto fd = open(controlFile.c_str(), O_WRONLY | O_CLOEXEC);
+
+        if (fd >= 0)
+        {
+            write(fd, controller, std::char_traits<char>::length(controller));
+            close(fd);
+        }
+    }
+}
+
+CodeExecutor::ControlGroup::~ControlGroup()
+{
+    if (m_created)
+    {
+        rmdir(m_path.c_str());
+    }
+}
+
+std::filesystem::path CodeExecutor::ControlGroup::path() const
+{
+    return m_path;
+}
+
+std::filesystem::path CodeExecutor::ControlGroup::processesFile() const
+{
+    return m_path / "cgroup.procs";
+}
+
+void CodeExecutor::ControlGroup::setCpuLimit(double cpus,
+                                             std::chrono::microseconds period)
+{
+    std::stringstream value;
+
+    if (cpus <= 0)
+    {
+        value << "max " << period.count();
+    }
+    else
+    {
+        auto quota = static_cast<long long>(std::llround(cpus * period.count()));
+
+        // Kernel minimal quota is 1 ms
+        value << std::max(quota, 1000ll) << ' ' << period.count();
+    }
+
+    writeFile("cpu.max", value.str());
+}
+
+void CodeExecutor::ControlGroup::setMemoryLimit(std::size_t bytes)
+{
+    writeFile("memory.max", bytes == 0 ? "max" : std::to_string(bytes));
+}
+
+bool CodeExecutor::ControlGroup::attach(pid_t pid) const
+{
+    auto fd = open(processesFile().c_str(), O_WRONLY | O_CLOEXEC);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    auto value = std::to_string(pid);
+    auto result = write(fd, value.c_str(), value.size());
+
+    close(fd);
+
+    return result == static_cast<ssize_t>(value.size());
+}
+
+std::filesystem::path CodeExecutor::ControlGroup::current()
+{
+    std::filesystem::path mountPoint;
+
+    // Line format: id parent major:minor root mount
+    // point options - type source super options
+    std::ifstream mounts("/proc/self/mountinfo");
+    std::string line;
+
+    while (std::getline(mounts, line))
+    {
+        auto separator = line.find(" - ");
+
+        if (separator == std::string::npos ||
+            line.compare(separator + 3, 8, "cgroup2 ") != 0)
+        {
+            continue;
+        }
+
+        std::stringstream fields(line);
+        std::string field;
+
+        for (int i = 0; i < 5; ++i)
+        {
+            fields >> field;
+        }
+
+        mountPoint = field;
+        break;
+    }
+
+    if (mountPoint.empty())
+    {
+        return std::filesystem::path();
+    }
+
+    // Unified hierarchy has id 0 and no controllers
+    std::ifstream groups("/proc/self/cgroup");
+
+    while (std::getline(groups, line))
+    {
+        if (line.compare(0, 3, "0::") == 0)
+        {
+            return mountPoint / std::filesystem::path(line.substr(3)).relative_path();
+        }
+    }
+
+    return mountPoint;
+}
+
+void CodeExecutor::ControlGroup::writeFile(const std::string& name,
+                                           const std::string& value) const
+{
+    auto path = m_path / name;
+    auto fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+
+    if (fd < 0)
+    {
+        throw std::runtime_error("Can't open " + path.string());
+    }
+
+    auto result = write(fd, value.c_str(), value.size());
+
+    close(fd);
+
+    if (result != static_cast<ssize_t>(value.size()))
+    {
+        throw std::runtime_error("Can't write " + path.string());
+    }
+}
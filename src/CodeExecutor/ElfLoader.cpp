@@ -0,0 +1,729 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include <dlfcn.h>
+#include <link.h>
+#include <sys/mman.h>
+#include "CodeExecutor/ElfLoader.hpp"
+#include "ElfSymbols.hpp"
+
+// Provided by libgcc, make unwinder find
+// frames of code, unknown to dynamic linker
+extern "C" void __register_frame(void* begin);
+extern "C" void __deregister_frame(void* begin);
+
+extern char** environ;
+
+class CodeExecutor::ElfLoader::Module : public CodeExecutor::Library
+{
+public:
+    Module(std::shared_ptr<const ElfLoader> loader,
+           std::shared_ptr<const std::string> image,
+           std::filesystem::path path) :
+        Library(std::move(path), nullptr),
+        m_loader(std::move(loader)),
+        m_image(std::move(image)),
+        m_block(nullptr),
+        m_blockSize(0),
+        m_bias(nullptr),
+        m_exports(),
+        m_finiArray(nullptr),
+        m_finiArraySize(0),
+        m_fini(nullptr),
+        m_frames(nullptr)
+    {
+        load();
+    }
+
+    ~Module() override
+    {
+        unload();
+    }
+
+    bool isLoaded() const override
+    {
+        return m_block != nullptr;
+    }
+
+    std::vector<std::string> symbols() const override
+    {
+        std::vector<std::string> result;
+        result.reserve(m_exports.size());
+
+        for (auto&& symbol : m_exports)
+        {
+            result.push_back(symbol.first);
+        }
+
+        return result;
+    }
+
+protected:
+    bool open(std::string& errorString) override
+    {
+        try
+        {
+            if (!m_image)
+            {
+                m_image = readFile(path());
+            }
+
+            map();
+        }
+        catch (const std::runtime_error& error)
+        {
+            release();
+
+            errorString = error.what();
+            return false;
+        }
+
+        return true;
+    }
+
+    bool close(std::string&) override
+    {
+        using Function = void (*)();
+
+        for (auto i = m_finiArraySize; i > 0; --i)
+        {
+            auto function = reinterpret_cast<Function>(m_finiArray[i - 1]);
+
+            if (function != nullptr && m_finiArray[i - 1] != ElfW(Addr)(-1))
+            {
+                function();
+            }
+        }
+
+        if (m_fini != nullptr)
+        {
+            m_fini();
+        }
+
+        release();
+
+        return true;
+    }
+
+    void* lookup(const char* name, std::string& errorString) const override
+    {
+        auto found = m_exports.find(name);
+
+        if (found == m_exports.end())
+        {
+            errorString = std::string("undefined symbol: ") + name;
+            return nullptr;
+        }
+
+        return found->second;
+    }
+
+private:
+    static std::shared_ptr<const std::string> readFile(const std::filesystem::path& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+
+        if (!file)
+        {
+            throw std::runtime_error("Can't read " + path.string());
+        }
+
+        return std::make_shared<const std::string>(
+            std::istreambuf_iterator<char>(file),
+            std::istreambuf_iterator<char>()
+        );
+    }
+
+    template<class T>
+    const T* at(std::size_t offset, std::size_t count = 1) const
+    {
+        if (offset > m_image->size() ||
+            count > (m_image->size() - offset) / sizeof(T))
+        {
+            throw std::runtime_error("ELF file is truncated");
+        }
+
+        return reinterpret_cast<const T*>(m_image->data() + offset);
+    }
+
+    template<class T>
+    T* address(ElfW(Addr) value) const
+    {
+        return reinterpret_cast<T*>(m_bias + value);
+    }
+
+    void map()
+    {
+        auto header = at<ElfW(Ehdr)>(0);
+
+        if (std::memcmp(header->e_ident, ELFMAG, SELFMAG) != 0)
+        {
+            throw std::runtime_error("Not an ELF file");
+        }
+
+        if (header->e_ident[EI_CLASS] != ELFCLASS64 ||
+            header->e_ident[EI_DATA] != ELFDATA2LSB ||
+            header->e_type != ET_DYN ||
+            header->e_machine != EM_X86_64)
+        {
+            throw std::runtime_error("Only x86-64 shared objects are supported");
+        }
+
+        auto segments = at<ElfW(Phdr)>(header->e_phoff, header->e_phnum);
+
+        auto page = CodeArena::pageSize();
+
+        ElfW(Addr) begin = ~ElfW(Addr)(0);
+        ElfW(Addr) end = 0;
+        std::size_t alignment = page;
+
+        const ElfW(Phdr)* dynamic = nullptr;
+        const ElfW(Phdr)* relro = nullptr;
+        const ElfW(Phdr)* frames = nullptr;
+
+        for (auto segment = segments; segment != segments + header->e_phnum; ++segment)
+        {
+            switch (segment->p_type)
+            {
+            case PT_LOAD:
+                if (segment->p_filesz > segment->p_memsz)
+                {
+                    throw std::runtime_error("Invalid loadable segment");
+                }
+
+                at<char>(segment->p_offset, segment->p_filesz);
+
+                begin = std::min(begin, segment->p_vaddr & ~ElfW(Addr)(page - 1));
+                end = std::max(end, segment->p_vaddr + segment->p_memsz);
+                alignment = std::max<std::size_t>(alignment, segment->p_align);
+                break;
+            case PT_DYNAMIC:
+                dynamic = segment;
+                break;
+            case PT_GNU_RELRO:
+                relro = segment;
+                break;
+            case PT_GNU_EH_FRAME:
+                frames = segment;
+                break;
+            case PT_TLS:
+                throw std::runtime_error("Thread local storage is not supported");
+            default:
+                break;
+            }
+        }
+
+        if (end <= begin || dynamic == nullptr)
+        {
+            throw std::runtime_error("Shared object has nothing to load");
+        }
+
+        // Whole last page is owned, so it's protected too
+        m_blockSize = (end - begin + page - 1) & ~(page - 1);
+        m_block = static_cast<char*>(m_loader->m_arena->allocate(m_blockSize, alignment));
+
+        if (m_block == nullptr)
+        {
+            throw std::runtime_error("Code arena is exhausted");
+        }
+
+        m_bias = m_block - begin;
+
+        // Block is zeroed, so only file part is copied
+        for (auto segment = segments; segment != segments + header->e_phnum; ++segment)
+        {
+            if (segment->p_type == PT_LOAD)
+            {
+                std::memcpy(
+                    address<char>(segment->p_vaddr),
+                    m_image->data() + segment->p_offset,
+                    segment->p_filesz
+                );
+            }
+        }
+
+        auto indirect = link(address<ElfW(Dyn)>(dynamic->p_vaddr));
+
+        // Resolvers of indirect functions are code of
+        // image, so they are called once it's executable.
+        // Relocated data stays writable until that.
+        if (!indirect.empty())
+        {
+            protect(segments, header->e_phnum, begin, nullptr);
+
+            for (auto&& reference : indirect)
+            {
+                auto value = reinterpret_cast<ElfW(Addr) (*)()>(reference.resolver)() + reference.addend;
+
+                if (reference.target != nullptr)
+                {
+                    *reference.target = value;
+                }
+                else
+                {
+                    *reference.exported = reinterpret_cast<void*>(value);
+                }
+            }
+        }
+
+        protect(segments, header->e_phnum, begin, relro);
+
+        if (frames != nullptr)
+        {
+            registerFrames(address<unsigned char>(frames->p_vaddr));
+        }
+
+        initialize(address<ElfW(Dyn)>(dynamic->p_vaddr));
+    }
+
+    // Reference, which value is returned by
+    // resolver of indirect function
+    struct Indirect
+    {
+        ElfW(Addr)* target;
+        void** exported;
+        ElfW(Addr) resolver;
+        ElfW(Sxword) addend;
+    };
+
+    std::vector<Indirect> link(const ElfW(Dyn)* dynamic)
+    {
+        std::vector<Indirect> indirect;
+
+        const ElfW(Sym)* symbolTable = nullptr;
+        const char* stringTable = nullptr;
+        const uint32_t* hashTable = nullptr;
+        const uint32_t* gnuHashTable = nullptr;
+
+        const ElfW(Rela)* relocations = nullptr;
+        std::size_t relocationsSize = 0;
+        const ElfW(Rela)* pltRelocations = nullptr;
+        std::size_t pltRelocationsSize = 0;
+
+        for (auto entry = dynamic; entry->d_tag != DT_NULL; ++entry)
+        {
+            switch (entry->d_tag)
+            {
+            case DT_SYMTAB:
+                symbolTable = address<const ElfW(Sym)>(entry->d_un.d_ptr);
+                break;
+            case DT_STRTAB:
+                stringTable = address<const char>(entry->d_un.d_ptr);
+                break;
+            case DT_HASH:
+                hashTable = address<const uint32_t>(entry->d_un.d_ptr);
+                break;
+            case DT_GNU_HASH:
+                gnuHashTable = address<const uint32_t>(entry->d_un.d_ptr);
+                break;
+            case DT_RELA:
+                relocations = address<const ElfW(Rela)>(entry->d_un.d_ptr);
+                break;
+            case DT_RELASZ:
+                relocationsSize = entry->d_un.d_val;
+                break;
+            case DT_JMPREL:
+                pltRelocations = address<const ElfW(Rela)>(entry->d_un.d_ptr);
+                break;
+            case DT_PLTRELSZ:
+                pltRelocationsSize = entry->d_un.d_val;
+                break;
+            case DT_PLTREL:
+                if (entry->d_un.d_val != DT_RELA)
+                {
+                    throw std::runtime_error("Only RELA relocations are supported");
+                }
+                break;
+            case DT_REL:
+            case DT_TEXTREL:
+                throw std::runtime_error("Only position independent RELA objects are supported");
+            default:
+                break;
+            }
+        }
+
+        if (symbolTable == nullptr || stringTable == nullptr)
+        {
+            throw std::runtime_error("Shared object has no symbol table");
+        }
+
+        auto count = Elf::symbolCount(hashTable, gnuHashTable);
+
+        // Exports are resolved before relocations,
+        // so own symbols bind to own definitions
+        for (std::size_t i = 1; i < count; ++i)
+        {
+            auto& symbol = symbolTable[i];
+
+            auto binding = ELF64_ST_BIND(symbol.st_info);
+            auto type = ELF64_ST_TYPE(symbol.st_info);
+
+            if (symbol.st_shndx == SHN_UNDEF || symbol.st_name == 0 ||
+                (binding != STB_GLOBAL && binding != STB_WEAK && binding != STB_GNU_UNIQUE) ||
+                (type != STT_FUNC && type != STT_OBJECT && type != STT_GNU_IFUNC))
+            {
+                continue;
+            }
+
+            m_exports.emplace(stringTable + symbol.st_name, nullptr);
+        }
+
+        auto symbolAddress = [&](uint32_t index) -> ElfW(Addr)
+        {
+            if (index == 0)
+            {
+                return 0;
+            }
+
+            auto& symbol = symbolTable[index];
+
+            if (symbol.st_shndx != SHN_UNDEF)
+            {
+                return reinterpret_cast<ElfW(Addr)>(m_bias) + symbol.st_value;
+            }
+
+            auto name = stringTable + symbol.st_name;
+            auto result = m_loader->import(name);
+
+            if (result == nullptr && ELF64_ST_BIND(symbol.st_info) != STB_WEAK)
+            {
+                throw std::runtime_error(std::string("Undefined symbol ") + name);
+            }
+
+            return reinterpret_cast<ElfW(Addr)>(result);
+        };
+
+        auto isIndirect = [&](uint32_t index)
+        {
+            auto& symbol = symbolTable[index];
+
+            return index != 0 &&
+                   symbol.st_shndx != SHN_UNDEF &&
+                   ELF64_ST_TYPE(symbol.st_info) == STT_GNU_IFUNC;
+        };
+
+        auto relocate = [&](const ElfW(Rela)* begin, std::size_t size)
+        {
+            for (auto relocation = begin; relocation != begin + size / sizeof(ElfW(Rela)); ++relocation)
+            {
+                auto target = address<ElfW(Addr)>(relocation->r_offset);
+
+                if (reinterpret_cast<char*>(target) < m_block ||
+                    reinterpret_cast<char*>(target + 1) > m_block + m_blockSize)
+                {
+                    throw std::runtime_error("Relocation is out of image");
+                }
+
+                auto symbol = ELF64_R_SYM(relocation->r_info);
+                auto addend = relocation->r_addend;
+
+                switch (ELF64_R_TYPE(relocation->r_info))
+                {
+                case R_X86_64_NONE:
+                    break;
+                case R_X86_64_RELATIVE:
+                    *target = reinterpret_cast<ElfW(Addr)>(m_bias) + addend;
+                    break;
+                case R_X86_64_64:
+                case R_X86_64_GLOB_DAT:
+                case R_X86_64_JUMP_SLOT:
+                    if (isIndirect(symbol))
+                    {
+                        indirect.push_back({target, nullptr, symbolAddress(symbol), addend});
+                    }
+                    else
+                    {
+                        *target = symbolAddress(symbol) + addend;
+                    }
+                    break;
+                case R_X86_64_IRELATIVE:
+                    indirect.push_back({
+                        target,
+                        nullptr,
+                        reinterpret_cast<ElfW(Addr)>(m_bias) + addend,
+                        0
+                    });
+                    break;
+                case R_X86_64_DTPMOD64:
+                case R_X86_64_DTPOFF64:
+                case R_X86_64_TPOFF64:
+                    throw std::runtime_error("Thread local storage is not supported");
+                default:
+                    throw std::runtime_error(
+                        "Unsupported relocation type " +
+                        std::to_string(ELF64_R_TYPE(relocation->r_info))
+                    );
+                }
+            }
+        };
+
+        if (relocations != nullptr)
+        {
+            relocate(relocations, relocationsSize);
+        }
+
+        // Functions are bound now, there is
+        // no lazy binding without dynamic linker
+        if (pltRelocations != nullptr)
+        {
+            relocate(pltRelocations, pltRelocationsSize);
+        }
+
+        for (std::size_t i = 1; i < count; ++i)
+        {
+            auto& symbol = symbolTable[i];
+
+            if (symbol.st_shndx == SHN_UNDEF || symbol.st_name == 0)
+            {
+                continue;
+            }
+
+            auto found = m_exports.find(stringTable + symbol.st_name);
+
+            if (found == m_exports.end())
+            {
+                continue;
+            }
+
+            auto value = reinterpret_cast<ElfW(Addr)>(m_bias) + symbol.st_value;
+
+            if (isIndirect(static_cast<uint32_t>(i)))
+            {
+                indirect.push_back({nullptr, &found->second, value, 0});
+            }
+            else
+            {
+                found->second = reinterpret_cast<void*>(value);
+            }
+        }
+
+        return indirect;
+    }
+
+    void protect(const ElfW(Phdr)* segments, std::size_t count, ElfW(Addr) begin, const ElfW(Phdr)* relro)
+    {
+        auto page = CodeArena::pageSize();
+
+        // Segments may share page, it gets access of both
+        auto pages = m_blockSize / page;
+
+        std::vector<int> access(pages, PROT_NONE);
+
+        for (auto segment = segments; segment != segments + count; ++segment)
+        {
+            if (segment->p_type != PT_LOAD)
+            {
+                continue;
+            }
+
+            int flags = PROT_NONE;
+
+            flags |= (segment->p_flags & PF_R) ? PROT_READ : 0;
+            flags |= (segment->p_flags & PF_W) ? PROT_WRITE : 0;
+            flags |= (segment->p_flags & PF_X) ? PROT_EXEC : 0;
+
+            auto first = (segment->p_vaddr - begin) / page;
+            auto last = (segment->p_vaddr + segment->p_memsz - begin + page - 1) / page;
+
+            for (auto i = first; i < last; ++i)
+            {
+                access[i] |= flags;
+            }
+        }
+
+        // Relocated data becomes read only, like
+        // dynamic linker does, partial last page stays
+        if (relro != nullptr)
+        {
+            auto first = (relro->p_vaddr - begin) / page;
+            auto last = (relro->p_vaddr + relro->p_memsz - begin) / page;
+
+            for (auto i = first; i < last; ++i)
+            {
+                access[i] &= ~PROT_WRITE;
+            }
+        }
+
+        for (std::size_t i = 0; i < pages;)
+        {
+            auto j = i;
+
+            while (j < pages && access[j] == access[i])
+            {
+                ++j;
+            }
+
+            if (mprotect(m_block + i * page, (j - i) * page, access[i]) != 0)
+            {
+                throw std::runtime_error("Can't protect loaded segments");
+            }
+
+            i = j;
+        }
+    }
+
+    void registerFrames(unsigned char* header)
+    {
+        // Version 1, frame pointer is signed
+        // 4 byte offset from its own position
+        constexpr unsigned char pcRelativeSigned4 = 0x1b;
+
+        if (header[0] != 1 || header[1] != pcRelativeSigned4)
+        {
+            return;
+        }
+
+        int32_t offset;
+        std::memcpy(&offset, header + 4, sizeof(offset));
+
+        m_frames = header + 4 + offset;
+
+        __register_frame(m_frames);
+    }
+
+    void initialize(const ElfW(Dyn)* dynamic)
+    {
+        using ArrayFunction = void (*)(int, char**, char**);
+
+        void (*init)() = nullptr;
+        const ElfW(Addr)* initArray = nullptr;
+        std::size_t initArraySize = 0;
+
+        for (auto entry = dynamic; entry->d_tag != DT_NULL; ++entry)
+        {
+            switch (entry->d_tag)
+            {
+            case DT_INIT:
+                init = address<void()>(entry->d_un.d_ptr);
+                break;
+            case DT_INIT_ARRAY:
+                initArray = address<const ElfW(Addr)>(entry->d_un.d_ptr);
+                break;
+            case DT_INIT_ARRAYSZ:
+                initArraySize = entry->d_un.d_val / sizeof(ElfW(Addr));
+                break;
+            case DT_FINI:
+                m_fini = address<void()>(entry->d_un.d_ptr);
+                break;
+            case DT_FINI_ARRAY:
+                m_finiArray = address<const ElfW(Addr)>(entry->d_un.d_ptr);
+                break;
+            case DT_FINI_ARRAYSZ:
+                m_finiArraySize = entry->d_un.d_val / sizeof(ElfW(Addr));
+                break;
+            default:
+                break;
+            }
+        }
+
+        if (init != nullptr)
+        {
+            init();
+        }
+
+        for (std::size_t i = 0; i < initArraySize; ++i)
+        {
+            if (initArray[i] != 0 && initArray[i] != ElfW(Addr)(-1))
+            {
+                reinterpret_cast<ArrayFunction>(initArray[i])(0, nullptr, environ);
+            }
+        }
+    }
+
+    void release()
+    {
+        if (m_frames != nullptr)
+        {
+            __deregister_frame(m_frames);
+            m_frames = nullptr;
+        }
+
+        if (m_block != nullptr)
+        {
+            m_loader->m_arena->release(m_block, m_blockSize);
+        }
+
+        m_block = nullptr;
+        m_blockSize = 0;
+        m_bias = nullptr;
+        m_exports.clear();
+        m_finiArray = nullptr;
+        m_finiArraySize = 0;
+        m_fini = nullptr;
+    }
+
+    std::shared_ptr<const ElfLoader> m_loader;
+    std::shared_ptr<const std::string> m_image;
+
+    char* m_block;
+    std::size_t m_blockSize;
+
+    // Difference between addresses in
+    // memory and in ELF file
+    char* m_bias;
+
+    std::unordered_map<std::string, void*> m_exports;
+
+    const ElfW(Addr)* m_finiArray;
+    std::size_t m_finiArraySize;
+    void (*m_fini)();
+
+    unsigned char* m_frames;
+};
+
+CodeExecutor::ElfLoader::ElfLoader(std::size_t arenaSize) :
+    m_arena(std::make_shared<CodeArena>(arenaSize)),
+    m_importsMutex(),
+    m_imports()
+{
+
+}
+
+void CodeExecutor::ElfLoader::addImport(const std::string& name, void* address)
+{
+    std::unique_lock<std::shared_mutex> lock(m_importsMutex);
+
+    m_imports[name] = address;
+}
+
+void* CodeExecutor::ElfLoader::import(const char* name) const
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(m_importsMutex);
+
+        auto found = m_imports.find(name);
+
+        if (found != m_imports.end())
+        {
+            return found->second;
+        }
+    }
+
+    // Process symbols don't change, so every
+    // name is looked up once per loader
+    auto result = dlsym(RTLD_DEFAULT, name);
+
+    std::unique_lock<std::shared_mutex> lock(m_importsMutex);
+
+    return m_imports.emplace(name, result).first->second;
+}
+
+CodeExecutor::LibraryPtr CodeExecutor::ElfLoader::load(std::shared_ptr<const std::string> image,
+                                                       std::filesystem::path path)
+{
+    return std::make_shared<Module>(shared_from_this(), std::move(image), std::move(path));
+}
+
+CodeExecutor::LibraryPtr CodeExecutor::ElfLoader::load(const std::filesystem::path& path)
+{
+    return std::make_shared<Module>(shared_from_this(), nullptr, path);
+}
+
+CodeExecutor::CodeArenaPtr CodeExecutor::ElfLoader::arena() const
+{
+    return m_arena;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <link.h>
+
+namespace CodeExecutor
+{
+    namespace Elf
+    {
+        /**
+         * @brief Function for getting number of
+         * symbols in dynamic symbol table. It's
+         * shared by `dlopen` based library and
+         * ELF loader.
+         * @param hash `DT_HASH` table or nullptr.
+         * @param gnuHash `DT_GNU_HASH` table or nullptr.
+         * @return Number of symbols.
+         */
+        inline std::size_t symbolCount(const uint32_t* hash, const uint32_t* gnuHash)
+        {
+            // Symbol count isn't stored directly. Classic
+            // hash has it as chain count, GNU hash has to be
+            // walked to the end of the last chain
+            if (hash != nullptr)
+            {
+                return hash[1];
+            }
+
+            if (gnuHash == nullptr)
+            {
+                return 0;
+            }
+
+            auto buckets = gnuHash[0];
+            auto offset = gnuHash[1];
+            auto bloomSize = gnuHash[2];
+
+            auto bucket = reinterpret_cast<const uint32_t*>(
+                reinterpret_cast<const ElfW(Addr)*>(gnuHash + 4) + bloomSize
+            );
+            auto chain = bucket + buckets;
+
+            auto last = buckets > 0 ? *std::max_element(bucket, bucket + buckets) : 0;
+
+            if (last < offset)
+            {
+                return offset;
+            }
+
+            while ((chain[last - offset] & 1) == 0)
+            {
+                ++last;
+            }
+
+            return last + 1;
+        }
+    }
+}
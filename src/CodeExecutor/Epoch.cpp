@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "CodeExecutor/Epoch.hpp"
+
+namespace
+{
+    /**
+     * @brief Structure, that describes reader
+     * thread. Epoch is 0 outside of critical
+     * section.
+     */
+    struct Record
+    {
+        std::atomic<uint64_t> epoch{0};
+        unsigned depth = 0;
+    };
+
+    struct Retired
+    {
+        uint64_t epoch;
+        std::shared_ptr<void> object;
+    };
+
+    struct State
+    {
+        // Starts from 1, so 0 can mark quiescent readers
+        std::atomic<uint64_t> epoch{1};
+
+        std::mutex mutex;
+        std::vector<Record*> records;
+        std::vector<Retired> retired;
+    };
+
+    State& state()
+    {
+        static State state;
+
+        return state;
+    }
+
+    /**
+     * @brief Class, that registers record
+     * of thread, while thread is alive.
+     */
+    class RecordHolder
+    {
+    public:
+        RecordHolder()
+        {
+            auto& shared = state();
+
+            std::lock_guard<std::mutex> lock(shared.mutex);
+
+            shared.records.push_back(&m_record);
+        }
+
+        ~RecordHolder()
+        {
+            auto& shared = state();
+
+            std::lock_guard<std::mutex> lock(shared.mutex);
+
+            shared.records.erase(
+                std::find(shared.records.begin(), shared.records.end(), &m_record)
+            );
+        }
+
+        Record& record()
+        {
+            return m_record;
+        }
+
+    private:
+        Record m_record;
+    };
+
+    Record& localRecord()
+    {
+        thread_local RecordHolder holder;
+
+        return holder.record();
+    }
+
+    // Must be called with locked mutex
+    uint64_t oldestReader(State& shared)
+    {
+        // Writer's updates must be visible before
+        // readers are checked
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        auto oldest = std::numeric_limits<uint64_t>::max();
+
+        for (auto record : shared.records)
+        {
+            auto epoch = record->epoch.load(std::memory_order_acquire);
+
+            if (epoch != 0)
+            {
+                oldest = std::min(oldest, epoch);
+            }
+        }
+
+        return oldest;
+    }
+}
+
+CodeExecutor::Epoch::Guard::Guard()
+{
+    auto& record = localRecord();
+
+    if (record.depth++ == 0)
+    {
+        record.epoch.store(
+            state().epoch.load(std::memory_order_acquire),
+            std::memory_order_relaxed
+        );
+
+        // Record must be visible before reader
+        // loads any protected pointer
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+CodeExecutor::Epoch::Guard::~Guard()
+{
+    auto& record = localRecord();
+
+    if (--record.depth == 0)
+    {
+        record.epoch.store(0, std::memory_order_release);
+    }
+}
+
+void CodeExecutor::Epoch::retire(std::shared_ptr<void> object)
+{
+    if (!object)
+    {
+        return;
+    }
+
+    auto& shared = state();
+
+    // Readers, that enter after advance, can't
+    // see object, so they don't delay it
+    auto epoch = shared.epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+
+    std::lock_guard<std::mutex> lock(shared.mutex);
+
+    shared.retired.push_back({epoch, std::move(object)});
+}
+
+std::size_t CodeExecutor::Epoch::reclaim()
+{
+    auto& shared = state();
+
+    std::vector<Retired> expired;
+
+    {
+        std::lock_guard<std::mutex> lock(shared.mutex);
+
+        auto oldest = oldestReader(shared);
+
+        auto split = std::partition(
+            shared.retired.begin(),
+            shared.retired.end(),
+            [oldest](const Retired& retired)
+            {
+                return retired.epoch > oldest;
+            }
+        );
+
+        std::move(split, shared.retired.end(), std::back_inserter(expired));
+
+        shared.retired.erase(split, shared.retired.end());
+    }
+
+    // Objects are destroyed without lock, their
+    // destructors may use epoch too
+    return expired.size();
+}
+
+void CodeExecutor::Epoch::synchronize()
+{
+    auto& shared = state();
+
+    auto target = shared.epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+
+    while (true)
+    {
+        {
+            std::lock_guard<std::mutex> lock(shared.mutex);
+
+            if (oldestReader(shared) >= target)
+            {
+                break;
+            }
+        }
+
+        std::this_thread::yield();
+    }
+
+    reclaim();
+}
+
+std::size_t CodeExecutor::Epoch::retired()
+{
+    auto& shared = state();
+
+    std::lock_guard<std::mutex> lock(shared.mutex);
+
+    return shared.retired.size();
+}
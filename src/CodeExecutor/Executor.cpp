@@ -0,0 +1,99 @@
+#include <algorithm>
+#include "CodeExecutor/Executor.hpp"
+
+CodeExecutor::Executor::Executor(unsigned int threads) :
+    m_mutex(),
+    m_condition(),
+    m_tasks(),
+    m_stopping(false),
+    m_threads()
+{
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    m_threads.reserve(threads);
+
+    for (unsigned int i = 0; i < threads; ++i)
+    {
+        m_threads.emplace_back(&Executor::run, this);
+    }
+}
+
+CodeExecutor::Executor::~Executor()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_stopping = true;
+    }
+
+    m_condition.notify_all();
+
+    for (auto&& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+void CodeExecutor::Executor::post(Task task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_tasks.push_back(std::move(task));
+    }
+
+    m_condition.notify_one();
+}
+
+unsigned int CodeExecutor::Executor::threads() const
+{
+    return static_cast<unsigned int>(m_threads.size());
+}
+
+CodeExecutor::ExecutorPtr CodeExecutor::Executor::global()
+{
+    static auto executor = std::make_shared<Executor>();
+
+    return executor;
+}
+
+void CodeExecutor::Executor::run()
+{
+    while (true)
+    {
+        Task task;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            m_condition.wait(
+                lock,
+                [this]()
+                {
+                    return m_stopping || !m_tasks.empty();
+                }
+            );
+
+            // Remaining tasks are executed before stop
+            if (m_tasks.empty())
+            {
+                return;
+            }
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+
+        try
+        {
+            task();
+        }
+        catch (...)
+        {
+            // Worker must survive task errors
+        }
+    }
+}
@@ -0,0 +1,374 @@
+#include <csignal>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include "CodeExecutor/ForkServer.hpp"
+
+// Maximum size of spawn request
+static const std::size_t requestSize = 128 * 1024;
+
+// stdin, stdout, stderr and reply descriptor
+static const int requestDescriptors = 4;
+
+std::mutex CodeExecutor::ForkServer::m_globalMutex;
+CodeExecutor::ForkServerPtr CodeExecutor::ForkServer::m_global;
+
+CodeExecutor::ForkServer::ForkServer(int socket, pid_t pid, HideArg) :
+    m_socket(socket),
+    m_pid(pid)
+{
+
+}
+
+CodeExecutor::ForkServer::~ForkServer()
+{
+    // Fork server exits, when control socket is closed
+    close(m_socket);
+
+    int status;
+    while (waitpid(m_pid, &status, 0) < 0 && errno == EINTR);
+}
+
+CodeExecutor::ForkServerPtr CodeExecutor::ForkServer::create()
+{
+    int sockets[2];
+
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sockets) != 0)
+    {
+        throw std::runtime_error("Can't create fork server socket.");
+    }
+
+    auto pid = fork();
+
+    if (pid < 0)
+    {
+        close(sockets[0]);
+        close(sockets[1]);
+
+        throw std::runtime_error("Can't start fork server.");
+    }
+
+    if (pid == 0)
+    {
+        close(sockets[0]);
+
+        serve(sockets[1]);
+    }
+
+    close(sockets[1]);
+
+    return std::make_shared<ForkServer>(sockets[0], pid, HideArg());
+}
+
+void CodeExecutor::ForkServer::setGlobal(CodeExecutor::ForkServerPtr server)
+{
+    std::lock_guard<std::mutex> lock(m_globalMutex);
+
+    m_global = std::move(server);
+}
+
+CodeExecutor::ForkServerPtr CodeExecutor::ForkServer::global()
+{
+    std::lock_guard<std::mutex> lock(m_globalMutex);
+
+    return m_global;
+}
+
+pid_t CodeExecutor::ForkServer::pid() const
+{
+    return m_pid;
+}
+
+int CodeExecutor::ForkServer::spawn(const std::filesystem::path& program,
+                                    const ArgumentsContainer& arguments,
+                                    const std::filesystem::path& workingDirectory,
+                                    int stdinFd,
+                                    int stdoutFd,
+                                    int stderrFd,
+                                    const std::filesystem::path& processesFile)
+{
+    // Request: program, working directory, control group
+    // and arguments, every one is terminated with zero byte
+    std::string request;
+
+    request += program.string();
+    request += '\0';
+    request += workingDirectory.string();
+    request += '\0';
+    request += processesFile.string();
+    request += '\0';
+
+    for (auto&& argument : arguments)
+    {
+        request += argument;
+        request += '\0';
+    }
+
+    if (request.size() > requestSize)
+    {
+        return -1;
+    }
+
+    int reply[2];
+
+    if (pipe2(reply, O_CLOEXEC) != 0)
+    {
+        return -1;
+    }
+
+    int descriptors[requestDescriptors] = {stdinFd, stdoutFd, stderrFd, reply[1]};
+
+    iovec data{};
+    data.iov_base = &request[0];
+    data.iov_len = request.size();
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(descriptors))] = {};
+
+    msghdr message{};
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    auto header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(descriptors));
+
+    std::copy(
+        reinterpret_cast<const char*>(descriptors),
+        reinterpret_cast<const char*>(descriptors) + sizeof(descriptors),
+        reinterpret_cast<char*>(CMSG_DATA(header))
+    );
+
+    // Sequential packets are never interleaved,
+    // so socket may be shared by threads
+    ssize_t result;
+    while ((result = sendmsg(m_socket, &message, MSG_NOSIGNAL)) < 0 && errno == EINTR);
+
+    close(reply[1]);
+
+    if (result < 0)
+    {
+        close(reply[0]);
+        return -1;
+    }
+
+    return reply[0];
+}
+
+int CodeExecutor::ForkServer::wait(int handle, rusage* usage)
+{
+    Reply reply;
+    std::size_t received = 0;
+
+    while (received < sizeof(reply))
+    {
+        auto result = read(
+            handle,
+            reinterpret_cast<char*>(&reply) + received,
+            sizeof(reply) - received
+        );
+
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (result <= 0)
+        {
+            close(handle);
+            return -1;
+        }
+
+        received += result;
+    }
+
+    close(handle);
+
+    if (usage != nullptr)
+    {
+        *usage = reply.usage;
+    }
+
+    return reply.status;
+}
+
+void CodeExecutor::ForkServer::serve(int socket)
+{
+    // Only control socket is kept from host process
+    if (socket != 3)
+    {
+        dup3(socket, 3, O_CLOEXEC);
+        socket = 3;
+    }
+
+#ifdef SYS_close_range
+    if (syscall(SYS_close_range, 4, ~0u, 0) != 0)
+#endif
+    {
+        for (long fd = 4, end = sysconf(_SC_OPEN_MAX); fd < end && fd < 65536; ++fd)
+        {
+            close(static_cast<int>(fd));
+        }
+    }
+
+    // Monitors are reaped automatically
+    signal(SIGCHLD, SIG_IGN);
+
+    static char request[requestSize + 1];
+
+    while (true)
+    {
+        iovec data{};
+        data.iov_base = request;
+        data.iov_len = requestSize;
+
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * requestDescriptors)] = {};
+
+        msghdr message{};
+        message.msg_iov = &data;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+
+        auto size = recvmsg(socket, &message, MSG_CMSG_CLOEXEC);
+
+        if (size < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        // Host closed socket
+        if (size <= 0)
+        {
+            _exit(0);
+        }
+
+        int descriptors[requestDescriptors];
+        int count = 0;
+
+        for (auto header = CMSG_FIRSTHDR(&message);
+             header != nullptr;
+             header = CMSG_NXTHDR(&message, header))
+        {
+            if (header->cmsg_level == SOL_SOCKET &&
+                header->cmsg_type == SCM_RIGHTS)
+            {
+                count = static_cast<int>((header->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+
+                std::copy(
+                    reinterpret_cast<const int*>(CMSG_DATA(header)),
+                    reinterpret_cast<const int*>(CMSG_DATA(header)) + std::min(count, requestDescriptors),
+                    descriptors
+                );
+            }
+        }
+
+        if (count != requestDescriptors)
+        {
+            for (int i = 0; i < std::min(count, requestDescriptors); ++i)
+            {
+                close(descriptors[i]);
+            }
+
+            continue;
+        }
+
+        request[size] = '\0';
+
+        // Monitor process spawns child, waits
+        // for it and sends status to host
+        if (fork() == 0)
+        {
+            std::vector<char*> argv;
+            char* workingDirectory = nullptr;
+            char* processesFile = nullptr;
+
+            for (ssize_t position = 0; position < size; position += std::char_traits<char>::length(request + position) + 1)
+            {
+                if (argv.size() == 1 && workingDirectory == nullptr)
+                {
+                    workingDirectory = request + position;
+                    continue;
+                }
+
+                if (argv.size() == 1 && processesFile == nullptr)
+                {
+                    processesFile = request + position;
+                    continue;
+                }
+
+                argv.push_back(request + position);
+            }
+
+            argv.push_back(nullptr);
+
+            signal(SIGCHLD, SIG_DFL);
+
+            auto pid = fork();
+
+            if (pid == 0)
+            {
+                dup2(descriptors[0], 0);
+                dup2(descriptors[1], 1);
+                dup2(descriptors[2], 2);
+
+                sigset_t signals;
+                sigemptyset(&signals);
+                sigprocmask(SIG_SETMASK, &signals, nullptr);
+
+                signal(SIGPIPE, SIG_DFL);
+
+                // Child joins group before program is
+                // executed, so whole program is limited
+                if (processesFile != nullptr && processesFile[0] != '\0')
+                {
+                    auto fd = open(processesFile, O_WRONLY | O_CLOEXEC);
+
+                    if (fd < 0 || write(fd, "0", 1) != 1)
+                    {
+                        _exit(127);
+                    }
+
+                    close(fd);
+                }
+
+                if (workingDirectory != nullptr &&
+                    workingDirectory[0] != '\0' &&
+                    chdir(workingDirectory) != 0)
+                {
+                    _exit(127);
+                }
+
+                execv(argv[0], argv.data());
+
+                _exit(127);
+            }
+
+            close(descriptors[0]);
+            close(descriptors[1]);
+            close(descriptors[2]);
+
+            Reply reply{};
+            reply.status = -1;
+
+            if (pid > 0)
+            {
+                while (wait4(pid, &reply.status, 0, &reply.usage) < 0 && errno == EINTR);
+            }
+
+            while (write(descriptors[3], &reply, sizeof(reply)) < 0 && errno == EINTR);
+
+            _exit(0);
+        }
+
+        for (auto descriptor : descriptors)
+        {
+            close(descriptor);
+        }
+    }
+}
@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+#include "CodeExecutor/IoUring.hpp"
+
+CodeExecutor::IoUring::IoUring(unsigned entries) :
+    m_fd(-1),
+    m_ring(MAP_FAILED),
+    m_ringSize(0),
+    m_sqes(nullptr),
+    m_sqesSize(0),
+    m_sqHead(nullptr),
+    m_sqTail(nullptr),
+    m_sqMask(nullptr),
+    m_sqArray(nullptr),
+    m_sqEntries(0),
+    m_sqLocalTail(0),
+    m_cqHead(nullptr),
+    m_cqTail(nullptr),
+    m_cqMask(nullptr),
+    m_cqes(nullptr),
+    m_supported()
+{
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+
+    m_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+
+    if (m_fd < 0)
+    {
+        throw std::runtime_error("Can't setup io_uring");
+    }
+
+    // Kernels without single mapping are older
+    // than any kernel with useful opcodes
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP))
+    {
+        close(m_fd);
+        throw std::runtime_error("io_uring is too old");
+    }
+
+    m_ringSize = std::max(
+        params.sq_off.array + params.sq_entries * sizeof(unsigned),
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe)
+    );
+
+    m_ring = mmap(
+        nullptr,
+        m_ringSize,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE,
+        m_fd,
+        IORING_OFF_SQ_RING
+    );
+
+    if (m_ring == MAP_FAILED)
+    {
+        close(m_fd);
+        throw std::runtime_error("Can't map io_uring rings");
+    }
+
+    m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+
+    auto sqes = mmap(
+        nullptr,
+        m_sqesSize,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE,
+        m_fd,
+        IORING_OFF_SQES
+    );
+
+    if (sqes == MAP_FAILED)
+    {
+        munmap(m_ring, m_ringSize);
+        close(m_fd);
+        throw std::runtime_error("Can't map io_uring entries");
+    }
+
+    m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+    auto ring = static_cast<char*>(m_ring);
+
+    m_sqHead = reinterpret_cast<unsigned*>(ring + params.sq_off.head);
+    m_sqTail = reinterpret_cast<unsigned*>(ring + params.sq_off.tail);
+    m_sqMask = reinterpret_cast<unsigned*>(ring + params.sq_off.ring_mask);
+    m_sqArray = reinterpret_cast<unsigned*>(ring + params.sq_off.array);
+    m_sqEntries = params.sq_entries;
+    m_sqLocalTail = *m_sqTail;
+
+    m_cqHead = reinterpret_cast<unsigned*>(ring + params.cq_off.head);
+    m_cqTail = reinterpret_cast<unsigned*>(ring + params.cq_off.tail);
+    m_cqMask = reinterpret_cast<unsigned*>(ring + params.cq_off.ring_mask);
+    m_cqes = reinterpret_cast<io_uring_cqe*>(ring + params.cq_off.cqes);
+
+    // Probe result has entry per opcode
+    auto probeSize = sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op);
+    std::unique_ptr<char[]> probeData(new char[probeSize]());
+
+    auto probe = reinterpret_cast<io_uring_probe*>(probeData.get());
+
+    if (syscall(__NR_io_uring_register, m_fd, IORING_REGISTER_PROBE, probe, 256) == 0)
+    {
+        for (unsigned i = 0; i < probe->ops_len && i < 256; ++i)
+        {
+            m_supported[i] = (probe->ops[i].flags & IO_URING_OP_SUPPORTED) ? 1 : 0;
+        }
+    }
+}
+
+CodeExecutor::IoUring::~IoUring()
+{
+    munmap(m_sqes, m_sqesSize);
+    munmap(m_ring, m_ringSize);
+    close(m_fd);
+}
+
+bool CodeExecutor::IoUring::isSupported(uint8_t opcode) const
+{
+    return m_supported[opcode] != 0;
+}
+
+io_uring_sqe* CodeExecutor::IoUring::acquire()
+{
+    auto head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+
+    if (m_sqLocalTail - head >= m_sqEntries)
+    {
+        return nullptr;
+    }
+
+    auto index = m_sqLocalTail & *m_sqMask;
+    auto sqe = &m_sqes[index];
+
+    std::memset(sqe, 0, sizeof(io_uring_sqe));
+
+    m_sqArray[index] = index;
+    ++m_sqLocalTail;
+
+    return sqe;
+}
+
+int CodeExecutor::IoUring::submit(unsigned wait)
+{
+    // Entries must be written before tail is published
+    __atomic_store_n(m_sqTail, m_sqLocalTail, __ATOMIC_RELEASE);
+
+    while (true)
+    {
+        // Kernel advances head over consumed entries
+        auto submitted = m_sqLocalTail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+
+        auto result = syscall(
+            __NR_io_uring_enter,
+            m_fd,
+            submitted,
+            wait,
+            wait > 0 ? IORING_ENTER_GETEVENTS : 0,
+            nullptr,
+            0
+        );
+
+        if (result >= 0)
+        {
+            return static_cast<int>(result);
+        }
+
+        if (errno != EINTR)
+        {
+            return -errno;
+        }
+    }
+}
+
+bool CodeExecutor::IoUring::pop(io_uring_cqe& cqe)
+{
+    auto head = *m_cqHead;
+
+    if (head == __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE))
+    {
+        return false;
+    }
+
+    cqe = m_cqes[head & *m_cqMask];
+
+    __atomic_store_n(m_cqHead, head + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+namespace
+{
+    // Failure is remembered, so unsupported
+    // kernel costs one system call per thread
+    thread_local bool localInitialized = false;
+    thread_local std::unique_ptr<CodeExecutor::IoUring> localRing;
+
+    // Memory of destroyed rings, which kernel
+    // may still use, is owned until process exit
+    std::mutex abandonedMutex;
+    std::vector<std::shared_ptr<const void>> abandoned;
+}
+
+CodeExecutor::IoUring* CodeExecutor::IoUring::local()
+{
+    if (!localInitialized)
+    {
+        localInitialized = true;
+
+        try
+        {
+            localRing.reset(new IoUring(8));
+
+            if (!localRing->isSupported(IORING_OP_READ) ||
+                !localRing->isSupported(IORING_OP_WRITE))
+            {
+                localRing.reset();
+            }
+        }
+        catch (const std::runtime_error&)
+        {
+            localRing.reset();
+        }
+    }
+
+    return localRing.get();
+}
+
+void CodeExecutor::IoUring::resetLocal(std::shared_ptr<const void> data)
+{
+    localInitialized = true;
+    localRing.reset();
+
+    if (data)
+    {
+        std::lock_guard<std::mutex> lock(abandonedMutex);
+
+        abandoned.push_back(std::move(data));
+    }
+}
@@ -1,27 +1,51 @@
+#include <mutex>
+#include <link.h>
 #include "CodeExecutor/Library.hpp"
+#include "CodeExecutor/SymbolRegistry.hpp"
+#include "ElfSymbols.hpp"
 
 CodeExecutor::Library::Library() :
     m_library(nullptr),
     m_path(),
-    m_errorString()
+    m_errorString(),
+    m_artifact(),
+    m_symbolsMutex(),
+    m_names(),
+    m_symbols(),
+    m_registries()
 {
 
 }
 
 CodeExecutor::Library::Library(const std::filesystem::path& path) :
-    m_library(dlopen(path.string().c_str(), RTLD_LAZY)),
-    m_path(path),
-    m_errorString()
+    Library(path, ArtifactPtr())
 {
-    auto errorString = dlerror();
-    if (errorString)
-    {
-        m_errorString = errorString;
-    }
+    load();
+}
+
+CodeExecutor::Library::Library(ArtifactPtr artifact) :
+    Library(artifact->path(), artifact)
+{
+    load();
+}
+
+CodeExecutor::Library::Library(std::filesystem::path path, ArtifactPtr artifact) :
+    m_library(nullptr),
+    m_path(std::move(path)),
+    m_errorString(),
+    m_artifact(std::move(artifact)),
+    m_symbolsMutex(),
+    m_names(),
+    m_symbols(),
+    m_registries()
+{
+
 }
 
 CodeExecutor::Library::~Library()
 {
+    detach();
+
     if (m_library)
     {
         dlclose(m_library);
@@ -35,6 +59,8 @@ std::filesystem::path CodeExecutor::Library::path() const
 
 std::string CodeExecutor::Library::errorString() const
 {
+    std::shared_lock<std::shared_mutex> lock(m_symbolsMutex);
+
     return m_errorString;
 }
 
@@ -45,28 +71,285 @@ bool CodeExecutor::Library::isLoaded() const
 
 bool CodeExecutor::Library::load()
 {
-    return false;
+    if (isLoaded())
+    {
+        return true;
+    }
+
+    std::string errorString;
+    auto result = open(errorString);
+
+    std::unique_lock<std::shared_mutex> lock(m_symbolsMutex);
+
+    m_errorString = std::move(errorString);
+
+    return result;
 }
 
 bool CodeExecutor::Library::unload()
 {
-    return false;
+    if (!isLoaded())
+    {
+        return false;
+    }
+
+    // Registered symbols would dangle after unloading
+    detach();
+
+    std::unique_lock<std::shared_mutex> lock(m_symbolsMutex);
+
+    m_registries.clear();
+    m_symbols.clear();
+    m_names.clear();
+
+    std::string errorString;
+    auto result = close(errorString);
+
+    if (!result)
+    {
+        m_errorString = std::move(errorString);
+    }
+
+    return result;
 }
 
 void* CodeExecutor::Library::resolve(const char* name)
 {
-    if (m_library == nullptr)
+    if (!isLoaded())
+    {
+        return nullptr;
+    }
+
+    {
+        std::shared_lock<std::shared_mutex> lock(m_symbolsMutex);
+
+        auto found = m_symbols.find(name);
+
+        if (found != m_symbols.end())
+        {
+            return found->second;
+        }
+    }
+
+    std::string errorString;
+    auto result = lookup(name, errorString);
+
+    std::unique_lock<std::shared_mutex> lock(m_symbolsMutex);
+
+    if (result == nullptr)
     {
+        m_errorString = std::move(errorString);
         return nullptr;
     }
 
+    // Other thread may have resolved it already
+    if (m_symbols.find(name) == m_symbols.end())
+    {
+        m_symbols.emplace(m_names.emplace_back(name), result);
+    }
+
+    return result;
+}
+
+std::vector<void*> CodeExecutor::Library::resolveAll(const std::vector<std::string>& names)
+{
+    std::vector<void*> result(names.size(), nullptr);
+
+    if (!isLoaded())
+    {
+        return result;
+    }
+
+    std::vector<std::size_t> missing;
+
+    {
+        std::shared_lock<std::shared_mutex> lock(m_symbolsMutex);
+
+        for (std::size_t i = 0; i < names.size(); ++i)
+        {
+            auto found = m_symbols.find(names[i]);
+
+            if (found != m_symbols.end())
+            {
+                result[i] = found->second;
+            }
+            else
+            {
+                missing.push_back(i);
+            }
+        }
+    }
+
+    if (missing.empty())
+    {
+        return result;
+    }
+
+    std::string lastError;
+
+    for (auto i : missing)
+    {
+        std::string errorString;
+
+        result[i] = lookup(names[i].c_str(), errorString);
+
+        if (result[i] == nullptr)
+        {
+            lastError = std::move(errorString);
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(m_symbolsMutex);
+
+    if (!lastError.empty())
+    {
+        m_errorString = std::move(lastError);
+    }
+
+    for (auto i : missing)
+    {
+        if (result[i] != nullptr && m_symbols.find(names[i]) == m_symbols.end())
+        {
+            m_symbols.emplace(m_names.emplace_back(names[i]), result[i]);
+        }
+    }
+
+    return result;
+}
+
+std::vector<std::string> CodeExecutor::Library::symbols() const
+{
+    std::vector<std::string> result;
+
+    link_map* map = nullptr;
+
+    if (m_library == nullptr ||
+        dlinfo(m_library, RTLD_DI_LINKMAP, &map) != 0 ||
+        map == nullptr)
+    {
+        return result;
+    }
+
+    // Loader relocates dynamic section in place on
+    // most architectures, but not on all of them
+    auto address = [map](ElfW(Addr) value)
+    {
+        return value < map->l_addr ? value + map->l_addr : value;
+    };
+
+    const ElfW(Sym)* symbolTable = nullptr;
+    const char* stringTable = nullptr;
+    const uint32_t* hashTable = nullptr;
+    const uint32_t* gnuHashTable = nullptr;
+
+    for (auto entry = map->l_ld; entry->d_tag != DT_NULL; ++entry)
+    {
+        switch (entry->d_tag)
+        {
+        case DT_SYMTAB:
+            symbolTable = reinterpret_cast<const ElfW(Sym)*>(address(entry->d_un.d_ptr));
+            break;
+        case DT_STRTAB:
+            stringTable = reinterpret_cast<const char*>(address(entry->d_un.d_ptr));
+            break;
+        case DT_HASH:
+            hashTable = reinterpret_cast<const uint32_t*>(address(entry->d_un.d_ptr));
+            break;
+        case DT_GNU_HASH:
+            gnuHashTable = reinterpret_cast<const uint32_t*>(address(entry->d_un.d_ptr));
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (symbolTable == nullptr || stringTable == nullptr)
+    {
+        return result;
+    }
+
+    auto count = Elf::symbolCount(hashTable, gnuHashTable);
+
+    for (std::size_t i = 1; i < count; ++i)
+    {
+        auto& symbol = symbolTable[i];
+
+        // Info layout is same for both ELF classes
+        auto binding = ELF64_ST_BIND(symbol.st_info);
+        auto type = ELF64_ST_TYPE(symbol.st_info);
+
+        if (symbol.st_shndx == SHN_UNDEF || symbol.st_name == 0)
+        {
+            continue;
+        }
+
+        if (binding != STB_GLOBAL && binding != STB_WEAK && binding != STB_GNU_UNIQUE)
+        {
+            continue;
+        }
+
+        if (type != STT_FUNC && type != STT_OBJECT && type != STT_GNU_IFUNC)
+        {
+            continue;
+        }
+
+        result.emplace_back(stringTable + symbol.st_name);
+    }
+
+    return result;
+}
+
+bool CodeExecutor::Library::open(std::string& errorString)
+{
+    if (m_path.empty())
+    {
+        errorString = "Library has no path";
+        return false;
+    }
+
+    m_library = dlopen(m_path.string().c_str(), RTLD_LAZY);
+
+    if (m_library == nullptr)
+    {
+        errorString = dlerror();
+    }
+
+    return m_library != nullptr;
+}
+
+bool CodeExecutor::Library::close(std::string& errorString)
+{
+    auto result = dlclose(m_library);
+    m_library = nullptr;
+
+    if (result != 0)
+    {
+        errorString = dlerror();
+    }
+
+    return result == 0;
+}
+
+void* CodeExecutor::Library::lookup(const char* name, std::string& errorString) const
+{
     auto result = dlsym(m_library, name);
-    auto errorString = dlerror();
-    if (errorString)
+
+    if (auto error = dlerror())
     {
-        m_errorString = errorString;
+        errorString = error;
         return nullptr;
     }
 
     return result;
 }
+
+void CodeExecutor::Library::detach()
+{
+    for (auto&& registry : m_registries)
+    {
+        if (auto locked = registry.lock())
+        {
+            locked->remove(this);
+        }
+    }
+}
@@ -0,0 +1,145 @@
+#include <stdexcept>
+#include "CodeExecutor/LibraryCache.hpp"
+
+CodeExecutor::LibraryCache::LibraryCache(std::size_t capacity) :
+    m_capacity(capacity),
+    m_mutex(),
+    m_libraries(),
+    m_usage(),
+    m_hits(0),
+    m_misses(0)
+{
+    if (m_capacity == 0)
+    {
+        throw std::runtime_error("Library cache capacity must be positive");
+    }
+}
+
+CodeExecutor::LibraryPtr CodeExecutor::LibraryCache::get(const std::string& key,
+                                                         const Factory& factory)
+{
+    std::promise<LibraryPtr> promise;
+    FuturePtr future;
+    FuturePtr own;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto library = m_libraries.find(key);
+
+        // Library is ready or being built by other thread
+        if (library != m_libraries.end())
+        {
+            future = library->second.future;
+
+            m_usage.splice(m_usage.begin(), m_usage, library->second.usage);
+        }
+        else
+        {
+            own = std::make_shared<std::shared_future<LibraryPtr>>(
+                promise.get_future().share()
+            );
+
+            m_usage.push_front(key);
+            m_libraries.emplace(key, Entry{own, m_usage.begin()});
+
+            // Evicted library stays alive for it's
+            // users and waiters of it's build
+            while (m_libraries.size() > m_capacity)
+            {
+                erase(m_libraries.find(m_usage.back()));
+            }
+        }
+    }
+
+    if (future)
+    {
+        ++m_hits;
+
+        return future->get();
+    }
+
+    ++m_misses;
+
+    try
+    {
+        auto library = factory();
+
+        promise.set_value(library);
+
+        return library;
+    }
+    catch (...)
+    {
+        promise.set_exception(std::current_exception());
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // Failed build is forgotten, so next
+        // request will try to build it again
+        auto library = m_libraries.find(key);
+
+        if (library != m_libraries.end() &&
+            library->second.future == own)
+        {
+            erase(library);
+        }
+
+        throw;
+    }
+}
+
+bool CodeExecutor::LibraryCache::contains(const std::string& key) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_libraries.find(key) != m_libraries.end();
+}
+
+void CodeExecutor::LibraryCache::remove(const std::string& key)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto library = m_libraries.find(key);
+
+    if (library != m_libraries.end())
+    {
+        erase(library);
+    }
+}
+
+void CodeExecutor::LibraryCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_libraries.clear();
+    m_usage.clear();
+}
+
+std::size_t CodeExecutor::LibraryCache::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_libraries.size();
+}
+
+std::size_t CodeExecutor::LibraryCache::capacity() const
+{
+    return m_capacity;
+}
+
+std::uint64_t CodeExecutor::LibraryCache::hits() const
+{
+    return m_hits;
+}
+
+std::uint64_t CodeExecutor::LibraryCache::misses() const
+{
+    return m_misses;
+}
+
+void CodeExecutor::LibraryCache::erase(LibrariesContainer::iterator library)
+{
+    m_usage.erase(library->second.usage);
+    m_libraries.erase(library);
+}
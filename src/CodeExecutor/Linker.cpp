@@ -1,2 +1,7 @@
 #include "CodeExecutor/Linker.hpp"
 
+CodeExecutor::LibraryPtr CodeExecutor::Linker::link(const std::vector<ObjectPtr>& objects,
+                                                    const ArtifactStoragePtr&)
+{
+    return link(objects);
+}
@@ -0,0 +1,46 @@
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "CodeExecutor/MemoryFile.hpp"
+
+CodeExecutor::MemoryFile::MemoryFile(const std::string& name) :
+    m_descriptor(memfd_create(name.c_str(), MFD_CLOEXEC)),
+    m_path()
+{
+    if (m_descriptor < 0)
+    {
+        throw std::runtime_error("Can't create memory file " + name);
+    }
+
+    // Path of host process is valid for children,
+    // `/proc/self` would point to child itself
+    m_path = "/proc/" + std::to_string(getpid()) + "/fd/" + std::to_string(m_descriptor);
+}
+
+CodeExecutor::MemoryFile::~MemoryFile()
+{
+    close(m_descriptor);
+}
+
+std::filesystem::path CodeExecutor::MemoryFile::path() const
+{
+    return m_path;
+}
+
+int CodeExecutor::MemoryFile::descriptor() const
+{
+    return m_descriptor;
+}
+
+std::size_t CodeExecutor::MemoryFile::size() const
+{
+    struct stat status{};
+
+    if (fstat(m_descriptor, &status) != 0)
+    {
+        return 0;
+    }
+
+    return static_cast<std::size_t>(status.st_size);
+}
@@ -0,0 +1,7 @@
+#include "CodeExecutor/MemoryFile.hpp"
+#include "CodeExecutor/MemoryStorage.hpp"
+
+CodeExecutor::ArtifactPtr CodeExecutor::MemoryStorage::create(const std::string& name)
+{
+    return std::make_shared<MemoryFile>(name);
+}
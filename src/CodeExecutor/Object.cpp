@@ -1,12 +1,43 @@
 #include "CodeExecutor/Object.hpp"
 
-CodeExecutor::Object::Object(const std::filesystem::path& file) :
-    m_path(file)
+CodeExecutor::Object::Object(const std::filesystem::path& file,
+                             std::string standardOutput,
+                             std::string standardError) :
+    m_path(file),
+    m_artifact(),
+    m_stdout(std::move(standardOutput)),
+    m_stderr(std::move(standardError))
 {
 
 }
 
+CodeExecutor::Object::Object(ArtifactPtr artifact,
+                             std::string standardOutput,
+                             std::string standardError) :
+    m_path(artifact->path()),
+    m_artifact(std::move(artifact)),
+    m_stdout(std::move(standardOutput)),
+    m_stderr(std::move(standardError))
+{
+
+}
+
+CodeExecutor::ArtifactPtr CodeExecutor::Object::artifact() const
+{
+    return m_artifact;
+}
+
 std::filesystem::path CodeExecutor::Object::path() const
 {
     return m_path;
 }
+
+const std::string& CodeExecutor::Object::standardOutput() const
+{
+    return m_stdout;
+}
+
+const std::string& CodeExecutor::Object::standardError() const
+{
+    return m_stderr;
+}
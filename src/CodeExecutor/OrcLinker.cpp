@@ -0,0 +1,718 @@
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ObjectFileInterface.h>
+#include <llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h>
+#include <llvm/ExecutionEngine/SectionMemoryManager.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Object/ObjectFile.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/TargetSelect.h>
+#include "CodeExecutor/OrcLinker.hpp"
+
+// Session reports linkage errors separately from
+// failed lookup. Materialization runs on looking up
+// thread, so error is kept per thread
+static thread_local std::string sessionError;
+
+static std::string takeError(llvm::Error error)
+{
+    auto result = llvm::toString(std::move(error));
+
+    if (!sessionError.empty())
+    {
+        result += ": " + sessionError;
+        sessionError.clear();
+    }
+
+    return result;
+}
+
+// Libraries by addresses of their `__dso_handle`, so
+// destructors of static objects are run by own library
+static std::mutex exitsMutex;
+static std::unordered_map<const void*, void*> exitHandles;
+
+struct CodeExecutor::OrcLinker::State
+{
+    // Loaded `.init_array` or `.fini_array` section
+    struct Section
+    {
+        bool finalizer;
+        unsigned int priority;
+        unsigned int object;
+        std::size_t index;
+        std::uint64_t address;
+        std::uint64_t size;
+    };
+
+    std::unique_ptr<llvm::orc::LLJIT> jit;
+    std::atomic<unsigned long long> counter{0};
+
+    // There is no platform, that runs initializers,
+    // so their sections are recorded, when objects are
+    // loaded, and are run by library after linkage
+    std::mutex sectionsMutex;
+    std::unordered_map<llvm::orc::JITDylib*, std::vector<Section>> sections;
+
+    void record(llvm::orc::MaterializationResponsibility& responsibility,
+                const llvm::object::ObjectFile& object,
+                const llvm::RuntimeDyld::LoadedObjectInfo& info)
+    {
+        std::vector<Section> loaded;
+
+        // Buffer of object is named by it's index
+        unsigned int objectIndex = 0;
+        object.getFileName().getAsInteger(10, objectIndex);
+
+        std::size_t index = 0;
+
+        for (auto&& section : object.sections())
+        {
+            ++index;
+
+            auto name = section.getName();
+
+            if (!name)
+            {
+                llvm::consumeError(name.takeError());
+                continue;
+            }
+
+            bool finalizer = name->find(".fini_array") == 0;
+
+            if (!finalizer && name->find(".init_array") != 0)
+            {
+                continue;
+            }
+
+            // Sections without priority are run after
+            // the ones with it, like linker orders them
+            unsigned int priority = 65535;
+            auto suffix = name->drop_front(11);
+
+            if (!suffix.empty() && suffix.front() == '.')
+            {
+                suffix.drop_front().getAsInteger(10, priority);
+            }
+
+            loaded.push_back({
+                finalizer,
+                priority,
+                objectIndex,
+                index,
+                info.getSectionLoadAddress(section),
+                section.getSize()
+            });
+        }
+
+        if (loaded.empty())
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(sectionsMutex);
+
+        auto& sections = this->sections[&responsibility.getTargetJITDylib()];
+        sections.insert(sections.end(), loaded.begin(), loaded.end());
+    }
+
+    std::vector<Section> take(llvm::orc::JITDylib* dylib)
+    {
+        std::lock_guard<std::mutex> lock(sectionsMutex);
+
+        auto found = sections.find(dylib);
+
+        if (found == sections.end())
+        {
+            return {};
+        }
+
+        auto result = std::move(found->second);
+        sections.erase(found);
+
+        return result;
+    }
+};
+
+class CodeExecutor::OrcLinker::Module : public CodeExecutor::Library
+{
+public:
+    Module(std::shared_ptr<State> state, std::vector<std::string> images) :
+        Library(std::filesystem::path(), nullptr),
+        m_state(std::move(state)),
+        m_images(std::move(images)),
+        m_dylib(nullptr),
+        m_symbols(),
+        m_finalizers(),
+        m_handle(nullptr),
+        m_exits()
+    {
+        load();
+    }
+
+    ~Module() override
+    {
+        unload();
+    }
+
+    bool isLoaded() const override
+    {
+        return m_dylib != nullptr;
+    }
+
+    std::vector<std::string> symbols() const override
+    {
+        return m_symbols;
+    }
+
+protected:
+    bool open(std::string& errorString) override
+    {
+        auto& jit = *m_state->jit;
+
+        auto dylib = jit.createJITDylib("library_" + std::to_string(++m_state->counter));
+
+        if (!dylib)
+        {
+            errorString = llvm::toString(dylib.takeError());
+            return false;
+        }
+
+        m_dylib = &*dylib;
+
+        auto generator = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+            jit.getDataLayout().getGlobalPrefix()
+        );
+
+        if (!generator)
+        {
+            return fail(llvm::toString(generator.takeError()), errorString);
+        }
+
+        m_dylib->addGenerator(std::move(*generator));
+
+        std::vector<std::string> first;
+        std::vector<std::string> imports;
+        llvm::orc::SymbolLookupSet initializers;
+        bool registersExits = false;
+
+        for (std::size_t i = 0; i < m_images.size(); ++i)
+        {
+            // Names make initializer symbols of objects
+            // unique and identify objects for their order
+            auto buffer = llvm::MemoryBuffer::getMemBufferCopy(m_images[i], std::to_string(i));
+            auto contents = inspect(*buffer);
+
+            // Only array sections are run
+            if (!contents.initializers.empty())
+            {
+                return fail(
+                    "Object " + std::to_string(i) + " has legacy initializers or finalizers (" +
+                    contents.initializers + "), they are not supported",
+                    errorString
+                );
+            }
+
+            auto interface = llvm::orc::getObjectFileInterface(
+                jit.getExecutionSession(),
+                buffer->getMemBufferRef()
+            );
+
+            if (!interface)
+            {
+                return fail(llvm::toString(interface.takeError()), errorString);
+            }
+
+            // Looking up initializer symbol links object,
+            // even if it has no exported symbols
+            if (interface->InitSymbol)
+            {
+                initializers.add(
+                    interface->InitSymbol,
+                    llvm::orc::SymbolLookupFlags::WeaklyReferencedSymbol
+                );
+            }
+
+            if (!contents.defined.empty())
+            {
+                first.push_back(contents.defined.front());
+            }
+            else
+            {
+                // Object without exported symbols is
+                // never linked, its imports are
+                // checked directly
+                imports.insert(imports.end(), contents.undefined.begin(), contents.undefined.end());
+            }
+
+            m_symbols.insert(m_symbols.end(), contents.defined.begin(), contents.defined.end());
+
+            registersExits = registersExits || std::find(
+                contents.undefined.begin(),
+                contents.undefined.end(),
+                "__dso_handle"
+            ) != contents.undefined.end();
+
+            if (auto error = jit.addObjectFile(*m_dylib, std::move(buffer)))
+            {
+                return fail(llvm::toString(std::move(error)), errorString);
+            }
+        }
+
+        first.insert(first.end(), imports.begin(), imports.end());
+
+        if (registersExits && !defineRuntime(errorString))
+        {
+            return false;
+        }
+
+        // Objects are linked on first lookup, so
+        // undefined symbols are reported by load
+        for (auto&& name : first)
+        {
+            auto symbol = jit.lookup(*m_dylib, name);
+
+            if (!symbol)
+            {
+                return fail(takeError(symbol.takeError()), errorString);
+            }
+        }
+
+        if (!initializers.empty())
+        {
+            auto linked = jit.getExecutionSession().lookup(
+                llvm::orc::makeJITDylibSearchOrder(
+                    m_dylib,
+                    llvm::orc::JITDylibLookupFlags::MatchAllSymbols
+                ),
+                initializers
+            );
+
+            if (!linked)
+            {
+                return fail(takeError(linked.takeError()), errorString);
+            }
+        }
+
+        initialize();
+
+        return true;
+    }
+
+    bool close(std::string& errorString) override
+    {
+        // Registered destructors run first,
+        // like `__cxa_finalize` runs them
+        std::vector<Exit> exits;
+
+        {
+            std::lock_guard<std::mutex> lock(exitsMutex);
+
+            exitHandles.erase(m_handle);
+            exits.swap(m_exits);
+        }
+
+        m_handle = nullptr;
+
+        for (auto exit = exits.rbegin(); exit != exits.rend(); ++exit)
+        {
+            exit->first(exit->second);
+        }
+
+        // Finalizers run in reverse order
+        for (auto function = m_finalizers.rbegin(); function != m_finalizers.rend(); ++function)
+        {
+            (*function)();
+        }
+
+        m_finalizers.clear();
+
+        // Sections of partially linked library
+        m_state->take(m_dylib);
+
+        auto error = m_state->jit->getExecutionSession().removeJITDylib(*m_dylib);
+
+        m_dylib = nullptr;
+        m_symbols.clear();
+
+        if (error)
+        {
+            errorString = llvm::toString(std::move(error));
+            return false;
+        }
+
+        return true;
+    }
+
+    void* lookup(const char* name, std::string& errorString) const override
+    {
+        auto symbol = m_state->jit->lookup(*m_dylib, name);
+
+        if (!symbol)
+        {
+            errorString = takeError(symbol.takeError());
+            return nullptr;
+        }
+
+#if LLVM_VERSION_MAJOR >= 15
+        return symbol->toPtr<void*>();
+#else
+        return reinterpret_cast<void*>(static_cast<uintptr_t>(symbol->getAddress()));
+#endif
+    }
+
+private:
+    using Function = void (*)();
+
+    using Exit = std::pair<void (*)(void*), void*>;
+
+    static int registerExit(void (*function)(void*), void* argument, void* handle)
+    {
+        // Function local statics may be
+        // constructed by any thread
+        std::lock_guard<std::mutex> lock(exitsMutex);
+
+        auto module = exitHandles.find(handle);
+
+        if (module == exitHandles.end())
+        {
+            return -1;
+        }
+
+        static_cast<Module*>(module->second)->m_exits.emplace_back(function, argument);
+
+        return 0;
+    }
+
+    bool defineRuntime(std::string& errorString)
+    {
+        auto& jit = *m_state->jit;
+        auto& session = jit.getExecutionSession();
+
+        // Handle is data of library itself, because
+        // objects refer to it by relative address
+        auto context = std::make_unique<llvm::LLVMContext>();
+        auto module = std::make_unique<llvm::Module>("runtime", *context);
+
+        module->setDataLayout(jit.getDataLayout());
+
+        auto type = llvm::Type::getInt8Ty(*context);
+
+        auto handle = new llvm::GlobalVariable(
+            *module,
+            type,
+            true,
+            llvm::GlobalValue::ExternalLinkage,
+            llvm::ConstantInt::get(type, 0),
+            "__dso_handle"
+        );
+
+        handle->setVisibility(llvm::GlobalValue::HiddenVisibility);
+
+        auto error = jit.addIRModule(
+            *m_dylib,
+            llvm::orc::ThreadSafeModule(std::move(module), std::move(context))
+        );
+
+        if (error)
+        {
+            return fail(llvm::toString(std::move(error)), errorString);
+        }
+
+        llvm::orc::SymbolMap runtime;
+
+#if LLVM_VERSION_MAJOR >= 17
+        runtime[jit.mangleAndIntern("__cxa_atexit")] = {
+            llvm::orc::ExecutorAddr::fromPtr(&registerExit),
+            llvm::JITSymbolFlags::Exported
+        };
+#else
+        runtime[jit.mangleAndIntern("__cxa_atexit")] = llvm::JITEvaluatedSymbol(
+            llvm::pointerToJITTargetAddress(&registerExit),
+            llvm::JITSymbolFlags::Exported
+        );
+#endif
+
+        if (auto error = m_dylib->define(llvm::orc::absoluteSymbols(std::move(runtime))))
+        {
+            return fail(llvm::toString(std::move(error)), errorString);
+        }
+
+        auto address = session.lookup(
+            llvm::orc::makeJITDylibSearchOrder(
+                m_dylib,
+                llvm::orc::JITDylibLookupFlags::MatchAllSymbols
+            ),
+            jit.mangleAndIntern("__dso_handle")
+        );
+
+        if (!address)
+        {
+            return fail(takeError(address.takeError()), errorString);
+        }
+
+#if LLVM_VERSION_MAJOR >= 17
+        m_handle = address->getAddress().toPtr<void*>();
+#else
+        m_handle = reinterpret_cast<void*>(static_cast<uintptr_t>(address->getAddress()));
+#endif
+
+        std::lock_guard<std::mutex> lock(exitsMutex);
+
+        exitHandles[m_handle] = this;
+
+        return true;
+    }
+
+    void initialize()
+    {
+        auto sections = m_state->take(m_dylib);
+
+        // Linker orders sections by priority,
+        // then by objects order
+        std::sort(
+            sections.begin(),
+            sections.end(),
+            [](const State::Section& lhs, const State::Section& rhs)
+            {
+                return std::tie(lhs.priority, lhs.object, lhs.index) <
+                       std::tie(rhs.priority, rhs.object, rhs.index);
+            }
+        );
+
+        std::vector<Function> initializers;
+
+        for (auto&& section : sections)
+        {
+            auto functions = reinterpret_cast<const Function*>(
+                static_cast<uintptr_t>(section.address)
+            );
+
+            auto& target = section.finalizer ? m_finalizers : initializers;
+
+            for (std::uint64_t i = 0; i < section.size / sizeof(Function); ++i)
+            {
+                if (functions[i] != nullptr)
+                {
+                    target.push_back(functions[i]);
+                }
+            }
+        }
+
+        for (auto function : initializers)
+        {
+            function();
+        }
+    }
+
+    bool fail(std::string error, std::string& errorString)
+    {
+        std::string ignored;
+        close(ignored);
+
+        errorString = std::move(error);
+        return false;
+    }
+
+    struct Contents
+    {
+        std::vector<std::string> defined;
+        std::vector<std::string> undefined;
+
+        // Names of unsupported constructor
+        // and destructor sections
+        std::string initializers;
+    };
+
+    static bool isInitializer(llvm::StringRef name)
+    {
+        for (auto prefix : {".preinit_array", ".ctors", ".dtors"})
+        {
+            if (name.find(prefix) == 0)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    static Contents inspect(const llvm::MemoryBuffer& buffer)
+    {
+        Contents result;
+
+        auto object = llvm::object::ObjectFile::createObjectFile(buffer.getMemBufferRef());
+
+        if (!object)
+        {
+            llvm::consumeError(object.takeError());
+            return result;
+        }
+
+        for (auto&& section : (*object)->sections())
+        {
+            auto name = section.getName();
+
+            if (!name)
+            {
+                llvm::consumeError(name.takeError());
+                continue;
+            }
+
+            if (isInitializer(*name))
+            {
+                result.initializers += result.initializers.empty() ? "" : ", ";
+                result.initializers += name->str();
+            }
+        }
+
+        for (auto&& symbol : (*object)->symbols())
+        {
+            auto flags = symbol.getFlags();
+            auto type = symbol.getType();
+            auto name = symbol.getName();
+
+            if (!flags || !type || !name)
+            {
+                llvm::consumeError(flags.takeError());
+                llvm::consumeError(type.takeError());
+                llvm::consumeError(name.takeError());
+                continue;
+            }
+
+            if ((*flags & llvm::object::SymbolRef::SF_Global) == 0)
+            {
+                continue;
+            }
+
+            // Weak imports may stay unresolved
+            if ((*flags & llvm::object::SymbolRef::SF_Undefined) != 0)
+            {
+                if ((*flags & llvm::object::SymbolRef::SF_Weak) == 0 && !name->empty())
+                {
+                    result.undefined.push_back(name->str());
+                }
+
+                continue;
+            }
+
+            if (*type != llvm::object::SymbolRef::ST_Function &&
+                *type != llvm::object::SymbolRef::ST_Data)
+            {
+                continue;
+            }
+
+            result.defined.push_back(name->str());
+        }
+
+        return result;
+    }
+
+    std::shared_ptr<State> m_state;
+    std::vector<std::string> m_images;
+
+    llvm::orc::JITDylib* m_dylib;
+    std::vector<std::string> m_symbols;
+    std::vector<Function> m_finalizers;
+
+    // Registered destructors are guarded by `exitsMutex`
+    void* m_handle;
+    std::vector<Exit> m_exits;
+};
+
+CodeExecutor::OrcLinker::OrcLinker() :
+    m_state(std::make_shared<State>())
+{
+    static std::once_flag initialized;
+
+    std::call_once(initialized, []()
+    {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+    });
+
+    auto state = m_state.get();
+
+    // Default layer of ELF records
+    // initializer sections of loaded objects
+    // Platform runs only initializers of IR,
+    // libraries run initializers of objects and
+    // have own `__dso_handle` and `__cxa_atexit`
+    auto jit = llvm::orc::LLJITBuilder()
+        .setPlatformSetUp(llvm::orc::setUpInactivePlatform)
+        .setObjectLinkingLayerCreator(
+            [state](llvm::orc::ExecutionSession& session, const llvm::Triple&)
+            {
+                auto layer = std::make_unique<llvm::orc::RTDyldObjectLinkingLayer>(
+                    session,
+                    []()
+                    {
+                        return std::make_unique<llvm::SectionMemoryManager>();
+                    }
+                );
+
+                layer->setNotifyLoaded(
+                    [state](llvm::orc::MaterializationResponsibility& responsibility,
+                            const llvm::object::ObjectFile& object,
+                            const llvm::RuntimeDyld::LoadedObjectInfo& info)
+                    {
+                        state->record(responsibility, object, info);
+                    }
+                );
+
+                return llvm::Expected<std::unique_ptr<llvm::orc::ObjectLayer>>(std::move(layer));
+            }
+        )
+        .create();
+
+    if (!jit)
+    {
+        throw std::runtime_error("Can't create JIT: " + llvm::toString(jit.takeError()));
+    }
+
+    m_state->jit = std::move(*jit);
+
+    m_state->jit->getExecutionSession().setErrorReporter([](llvm::Error error)
+    {
+        sessionError = llvm::toString(std::move(error));
+    });
+}
+
+CodeExecutor::OrcLinker::~OrcLinker() = default;
+
+CodeExecutor::LibraryPtr CodeExecutor::OrcLinker::link(const std::vector<ObjectPtr>& objects)
+{
+    std::vector<std::string> images;
+    images.reserve(objects.size());
+
+    // Objects are copied, so their files
+    // can be removed after linkage
+    for (auto&& object : objects)
+    {
+        std::ifstream file(object->path(), std::ios::binary);
+
+        if (!file)
+        {
+            throw std::runtime_error("Can't read object " + object->path().string());
+        }
+
+        images.emplace_back(
+            std::istreambuf_iterator<char>(file),
+            std::istreambuf_iterator<char>()
+        );
+    }
+
+    return std::make_shared<Module>(m_state, std::move(images));
+}
@@ -1,49 +1,81 @@
-#include <zconf.h>
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <ctime>
 #include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
 #include <wait.h>
+#include "CodeExecutor/IoUring.hpp"
 #include "CodeExecutor/Process.hpp"
 
-template<typename Stream>
-void readFd(int fd, Stream& ss)
+namespace
 {
-    char buffer[1024];
-
-    while (true)
+    /**
+     * @brief Class, that blocks SIGPIPE for
+     * calling thread. Child may exit without
+     * reading whole input, then SIGPIPE is raised
+     * for writing thread only. It's consumed on
+     * destruction.
+     */
+    class PipeSignalBlocker
     {
-        auto result = read(fd, buffer, 1024);
+    public:
+        PipeSignalBlocker()
+        {
+            sigemptyset(&m_signal);
+            sigaddset(&m_signal, SIGPIPE);
+
+            pthread_sigmask(SIG_BLOCK, &m_signal, &m_previous);
 
-        if (result < 0)
+            sigset_t pending;
+            sigpending(&pending);
+            m_wasPending = sigismember(&pending, SIGPIPE) == 1;
+        }
+
+        ~PipeSignalBlocker()
         {
-            if (errno == EAGAIN)
-            {
-                continue;
-            }
-            else
+            if (!m_wasPending)
             {
-                return;
+                timespec timeout = {0, 0};
+
+                while (sigtimedwait(&m_signal, nullptr, &timeout) < 0 &&
+                       errno == EINTR);
             }
-        }
-        else if (result == 0)
-        {
-            return;
-        }
 
-        buffer[result] = '\0';
+            pthread_sigmask(SIG_SETMASK, &m_previous, nullptr);
+        }
 
-        ss << buffer;
-    }
+    private:
+        sigset_t m_signal;
+        sigset_t m_previous;
+        bool m_wasPending;
+    };
 }
 
 CodeExecutor::Process::Process() :
     m_workingDirectory(std::filesystem::current_path()),
     m_program(),
     m_arguments(),
-    m_inputData(),
+    m_inputData(std::make_shared<const std::string>()),
     m_stdoutFile(),
     m_stderrFile(),
     m_stderrStream(),
     m_stdoutStream(),
-    m_exitCode(0)
+    m_stdoutCallback(),
+    m_stderrCallback(),
+    m_captureLimit(0),
+    m_stdoutCaptured(0),
+    m_stderrCaptured(0),
+    m_ioEngine(IoEngine::Poll),
+    m_exitCode(0),
+    m_forkServer(),
+    m_resourceUsage(),
+    m_controlGroup()
 {
 
 }
@@ -53,12 +85,21 @@ CodeExecutor::Process::Process(std::string command,
     m_workingDirectory(std::filesystem::current_path()),
     m_program(std::move(command)),
     m_arguments(std::move(arguments)),
-    m_inputData(),
+    m_inputData(std::make_shared<const std::string>()),
     m_stdoutFile(),
     m_stderrFile(),
     m_stderrStream(),
     m_stdoutStream(),
-    m_exitCode(0)
+    m_stdoutCallback(),
+    m_stderrCallback(),
+    m_captureLimit(0),
+    m_stdoutCaptured(0),
+    m_stderrCaptured(0),
+    m_ioEngine(IoEngine::Poll),
+    m_exitCode(0),
+    m_forkServer(),
+    m_resourceUsage(),
+    m_controlGroup()
 {
 
 }
@@ -73,6 +114,11 @@ int CodeExecutor::Process::exitCode() const
     return m_exitCode;
 }
 
+const CodeExecutor::Process::ResourceUsage& CodeExecutor::Process::resourceUsage() const
+{
+    return m_resourceUsage;
+}
+
 std::string CodeExecutor::Process::readStandardError() const
 {
     return m_stderrStream.str();
@@ -135,121 +181,864 @@ void CodeExecutor::Process::setWorkingDirectory(std::filesystem::path path)
 
 void CodeExecutor::Process::setInputData(std::string data)
 {
-    m_inputData = std::move(data);
+    m_inputData = std::make_shared<const std::string>(std::move(data));
 }
 
 std::string CodeExecutor::Process::inputData() const
+{
+    return *m_inputData;
+}
+
+void CodeExecutor::Process::setInputBuffer(std::shared_ptr<const std::string> data)
+{
+    if (!data)
+    {
+        data = std::make_shared<const std::string>();
+    }
+
+    m_inputData = std::move(data);
+}
+
+std::shared_ptr<const std::string> CodeExecutor::Process::inputBuffer() const
 {
     return m_inputData;
 }
 
+void CodeExecutor::Process::setStandardOutputCallback(OutputCallback callback)
+{
+    m_stdoutCallback = std::move(callback);
+}
+
+void CodeExecutor::Process::setStandardErrorCallback(OutputCallback callback)
+{
+    m_stderrCallback = std::move(callback);
+}
+
+void CodeExecutor::Process::setCaptureLimit(std::size_t bytes)
+{
+    m_captureLimit = bytes;
+}
+
+std::size_t CodeExecutor::Process::captureLimit() const
+{
+    return m_captureLimit;
+}
+
+void CodeExecutor::Process::setIoEngine(IoEngine engine)
+{
+    m_ioEngine = engine;
+}
+
+CodeExecutor::Process::IoEngine CodeExecutor::Process::ioEngine() const
+{
+    return m_ioEngine;
+}
+
+void CodeExecutor::Process::setControlGroup(ControlGroupPtr group)
+{
+    m_controlGroup = std::move(group);
+}
+
+CodeExecutor::ControlGroupPtr CodeExecutor::Process::controlGroup() const
+{
+    return m_controlGroup;
+}
+
+void CodeExecutor::Process::setForkServer(CodeExecutor::ForkServerPtr server)
+{
+    m_forkServer = std::move(server);
+}
+
+CodeExecutor::ForkServerPtr CodeExecutor::Process::forkServer() const
+{
+    return m_forkServer;
+}
+
 int CodeExecutor::Process::start()
 {
-    // Preparing replacing stdout, stdin, stderr
-    int stdoutfd[2];
-    int stdinfd[2];
-    int stderrfd[2];
+    Launched launched;
 
-    int oldstdin;
-    int oldstdout;
-    int oldstderr;
+    if (!launch(launched, false))
+    {
+        return m_exitCode;
+    }
 
-    pipe(stdoutfd); // Where the parent is going to write to
-    pipe(stdinfd);  // From where parent is going to read stdout
-    pipe(stderrfd); // From where parent is going to read stderr
+    // Engine is chosen at runtime, kernel
+    // may have no io_uring support
+    auto ring = m_ioEngine == IoEngine::Uring ? IoUring::local() : nullptr;
 
-    oldstdin  = dup(0); // Saving current stdin
-    oldstdout = dup(1); // Saving current stdout
-    oldstderr = dup(2); // Saving current stderr
+    if (ring)
+    {
+        communicate(*ring, launched);
+        return m_exitCode;
+    }
 
-    close(0); // Closing current stdin
-    close(1); // Closing current stdout
-    close(2); // Closing current stderr
+    communicate(
+        launched.input,
+        launched.output,
+        launched.error,
+        0,
+        launched.wait
+    );
 
-    dup2(stdoutfd[0], 0); // Make the read end of stdoutfd pipe as stdin
-    dup2(stdinfd[1],  1); // Make the write end of stdinfd as stdout
-    dup2(stderrfd[1], 2); // Make the write end of stderrfd as stderr
+    return m_exitCode;
+}
 
-    auto pid = fork();
+bool CodeExecutor::Process::launch(Launched& launched, bool watchable)
+{
+    m_stdoutCaptured = 0;
+    m_stderrCaptured = 0;
 
-    // If it's child process
-    if (!pid)
+    int inputfd[2];
+    int outputfd[2];
+    int errorfd[2];
+
+    // Pipes are not inherited by children, spawned
+    // simultaneously from other threads. Otherwise
+    // they would keep stdin of this child open.
+    if (pipe2(inputfd, O_CLOEXEC) != 0)
     {
-        // Path to program, arguments and nullptr
-        char* argv[m_arguments.size() + 2];
+        m_exitCode = -1;
+        return false;
+    }
+
+    if (pipe2(outputfd, O_CLOEXEC) != 0)
+    {
+        close(inputfd[0]);
+        close(inputfd[1]);
+
+        m_exitCode = -1;
+        return false;
+    }
+
+    if (pipe2(errorfd, O_CLOEXEC) != 0)
+    {
+        close(inputfd[0]);
+        close(inputfd[1]);
+        close(outputfd[0]);
+        close(outputfd[1]);
+
+        m_exitCode = -1;
+        return false;
+    }
 
-        // Maybe copy needed
-        auto programString = m_program.string();
+    launched.pid = -1;
+    launched.waitDescriptor = -1;
+    launched.wait = nullptr;
 
-        // Path to program
-        argv[0] = new char[programString.size() + 1];
-        argv[0][programString.size()] = '\0';
-        std::copy(programString.begin(), programString.end(), argv[0]);
+    auto server = m_forkServer ? m_forkServer : ForkServer::global();
 
-        int i = 0;
-        // Copying arguments
-        for (auto&& arg : m_arguments)
+    // Fork server may be unavailable, then
+    // process is spawned by host
+    if (server)
+    {
+        auto handle = server->spawn(
+            m_program,
+            m_arguments,
+            m_workingDirectory,
+            inputfd[0],
+            outputfd[1],
+            errorfd[1],
+            m_controlGroup ? m_controlGroup->processesFile() : std::filesystem::path()
+        );
+
+        if (handle >= 0)
         {
-            argv[++i] = new char[arg.size() + 1];
-            argv[i][arg.size()] = '\0';
-            std::copy(arg.begin(), arg.end(), argv[i]);
+            // Status is written to handle on child exit
+            launched.waitDescriptor = handle;
+            launched.wait = [handle](rusage& usage)
+            {
+                return ForkServer::wait(handle, &usage);
+            };
         }
+    }
 
-        // Setting null
-        argv[m_arguments.size() + 1] = nullptr;
+    if (!launched.wait)
+    {
+        auto pid = spawn(inputfd[0], outputfd[1], errorfd[1]);
 
-        // Closing useless fd
-        close(stdoutfd[0]);
-        close(stdoutfd[1]);
+        if (pid > 0)
+        {
+            int pidfd = -1;
 
-        close(stdinfd[0]);
-        close(stdinfd[1]);
+#ifdef SYS_pidfd_open
+            // Older kernels have no pidfd, then
+            // exit is detected by outputs EOF
+            if (watchable)
+            {
+                pidfd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+                pidfd = pidfd < 0 ? -1 : pidfd;
+            }
+#endif
+
+            launched.pid = pid;
+            launched.waitDescriptor = pidfd;
+            launched.wait = [pid, pidfd](rusage& usage)
+            {
+                int status;
 
-        close(stderrfd[0]);
-        close(stderrfd[1]);
+                while (wait4(pid, &status, 0, &usage) < 0)
+                {
+                    if (errno != EINTR)
+                    {
+                        status = -1;
+                        break;
+                    }
+                }
 
-        execv(argv[0], argv);
+                if (pidfd >= 0)
+                {
+                    close(pidfd);
+                }
+
+                return status;
+            };
+        }
+    }
+
+    // Child ends are duplicated by child
+    close(inputfd[0]);
+    close(outputfd[1]);
+    close(errorfd[1]);
+
+    if (!launched.wait)
+    {
+        close(inputfd[1]);
+        close(outputfd[0]);
+        close(errorfd[0]);
+
+        m_stderrStream << "Can't start " << m_program.string() << '\n';
+
+        // Same code as shell uses for not found command
+        m_exitCode = 127;
+        return false;
+    }
+
+    launched.input = inputfd[1];
+    launched.output = outputfd[0];
+    launched.error = errorfd[0];
+
+    // Large input is passed with fewer wakeups.
+    // Unprivileged limit is 1 MiB by default.
+    if (m_inputData->size() > 65536)
+    {
+        auto size = std::min<std::size_t>(m_inputData->size(), 1 << 20);
+
+        fcntl(launched.input, F_SETPIPE_SZ, static_cast<int>(size));
+    }
+
+    return true;
+}
+
+void CodeExecutor::Process::consumeOutput(bool error, const char* data, std::size_t size)
+{
+    auto& callback = error ? m_stderrCallback : m_stdoutCallback;
+    auto& stream = error ? m_stderrStream : m_stdoutStream;
+    auto& captured = error ? m_stderrCaptured : m_stdoutCaptured;
+
+    if (callback)
+    {
+        callback(data, size);
+    }
+
+    if (m_captureLimit != 0)
+    {
+        size = std::min(size, m_captureLimit - captured);
+    }
+
+    stream.write(data, size);
+    captured += size;
+}
+
+void CodeExecutor::Process::finish(int status, const rusage& usage)
+{
+    if (status == -1)
+    {
+        m_exitCode = -1;
+    }
+    else if (WIFSIGNALED(status))
+    {
+        // Shell convention, so killed child (for
+        // example by OOM killer) is never successful
+        m_exitCode = 128 + WTERMSIG(status);
     }
     else
     {
-        // Restoring the original std fds of parent
-        close(0);
-        close(1);
-        close(2);
+        m_exitCode = WEXITSTATUS(status);
+    }
+
+    m_resourceUsage.userTime = std::chrono::seconds(usage.ru_utime.tv_sec) +
+                               std::chrono::microseconds(usage.ru_utime.tv_usec);
+    m_resourceUsage.systemTime = std::chrono::seconds(usage.ru_stime.tv_sec) +
+                                 std::chrono::microseconds(usage.ru_stime.tv_usec);
+
+    // Linux reports it in kilobytes
+    m_resourceUsage.maxResidentSetSize = static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+    m_resourceUsage.minorPageFaults = static_cast<std::size_t>(usage.ru_minflt);
+    m_resourceUsage.majorPageFaults = static_cast<std::size_t>(usage.ru_majflt);
+}
+
+pid_t CodeExecutor::Process::spawn(int input, int output, int error)
+{
+    // Arguments are prepared before spawning, child
+    // only duplicates descriptors and executes program
+    auto program = m_program.string();
+
+    std::vector<char*> argv;
+    argv.reserve(m_arguments.size() + 2);
+
+    argv.push_back(&program[0]);
+
+    for (auto&& argument : m_arguments)
+    {
+        argv.push_back(const_cast<char*>(argument.c_str()));
+    }
 
-        dup2(oldstdin,  0);
-        dup2(oldstdout, 1);
-        dup2(oldstderr, 2);
+    argv.push_back(nullptr);
 
-        close(stdoutfd[0]);
-        close(stdinfd [1]);
-        close(stderrfd[1]);
+    auto workingDirectory = m_workingDirectory.string();
 
-        // Writing to child's stdin
-        write(
-            stdoutfd[1],
-            m_inputData.c_str(),
-            m_inputData.size()
+    // posix_spawn can't place child into group, so
+    // child is forked and joins group before program
+    // is executed
+    if (m_controlGroup)
+    {
+        auto processesFd = open(
+            m_controlGroup->processesFile().c_str(),
+            O_WRONLY | O_CLOEXEC
         );
 
+        if (processesFd < 0)
+        {
+            return -1;
+        }
+
+        auto pid = fork();
+
+        if (pid == 0)
+        {
+            // Only async signal safe calls are made
+            dup2(input, 0);
+            dup2(output, 1);
+            dup2(error, 2);
+
+            sigset_t signals;
+            sigemptyset(&signals);
+            sigprocmask(SIG_SETMASK, &signals, nullptr);
+
+            signal(SIGPIPE, SIG_DFL);
+
+            if (write(processesFd, "0", 1) != 1 ||
+                (!workingDirectory.empty() && chdir(workingDirectory.c_str()) != 0))
+            {
+                _exit(127);
+            }
+
+            execv(argv[0], argv.data());
+
+            _exit(127);
+        }
+
+        close(processesFd);
+
+        return pid;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+
+    // Duplicates have no close-on-exec flag,
+    // other pipe ends are closed on exec
+    posix_spawn_file_actions_adddup2(&actions, input, 0);
+    posix_spawn_file_actions_adddup2(&actions, output, 1);
+    posix_spawn_file_actions_adddup2(&actions, error, 2);
+
+    if (!workingDirectory.empty())
+    {
+        posix_spawn_file_actions_addchdir_np(&actions, workingDirectory.c_str());
+    }
+
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+
+    // Child doesn't inherit signal mask of calling
+    // thread and ignored SIGPIPE of host
+    sigset_t signals;
+    sigemptyset(&signals);
+    posix_spawnattr_setsigmask(&attributes, &signals);
+
+    sigaddset(&signals, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attributes, &signals);
+
+    posix_spawnattr_setflags(
+        &attributes,
+        POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF
+    );
+
+    pid_t pid;
+
+    auto result = posix_spawn(
+        &pid,
+        argv[0],
+        &actions,
+        &attributes,
+        argv.data(),
+        environ
+    );
+
+    posix_spawnattr_destroy(&attributes);
+    posix_spawn_file_actions_destroy(&actions);
+
+    return result == 0 ? pid : -1;
+}
+
+void CodeExecutor::Process::communicate(int input,
+                                        int output,
+                                        int error,
+                                        std::size_t written,
+                                        const Waiter& wait)
+{
+    int channels[] = {output, error};
+
+    PipeSignalBlocker blocker;
+
+    if (input >= 0 && written == m_inputData->size())
+    {
         // Closing stdin, to force EOF
-        close(stdoutfd[1]);
+        close(input);
+        input = -1;
+    }
 
-        // Making stdout and stderr nonblocking
-        makeNonBlocking(stdinfd[0]);
-        makeNonBlocking(stderrfd[0]);
+    // Closed descriptors are -1 and ignored
+    for (auto fd : {input, output, error})
+    {
+        if (fd >= 0)
+        {
+            makeNonBlocking(fd);
+        }
+    }
 
-        // Waiting child to end
-        int status;
-        waitpid(pid, &status, 0);
-        m_exitCode = WEXITSTATUS(status);
+    char buffer[16384];
+
+    // Input is fed and both outputs are drained at the
+    // same time, so child never blocks on full pipe
+    while (input >= 0 || channels[0] >= 0 || channels[1] >= 0)
+    {
+        pollfd descriptors[3] = {
+            {input, POLLOUT, 0},
+            {channels[0], POLLIN, 0},
+            {channels[1], POLLIN, 0}
+        };
 
-        // Reading stdout
-        readFd(stdinfd[0], m_stdoutStream);
-        readFd(stderrfd[0], m_stderrStream);
+        // Negative descriptors are ignored by poll
+        if (poll(descriptors, 3, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            break;
+        }
+
+        if (descriptors[0].revents != 0)
+        {
+            auto result = writeInput(input, written);
+
+            if (result > 0)
+            {
+                written += result;
+            }
+
+            if ((result < 0 && errno != EAGAIN && errno != EINTR) ||
+                written == m_inputData->size())
+            {
+                close(input);
+                input = -1;
+            }
+        }
+
+        for (std::size_t i = 0; i < 2; ++i)
+        {
+            auto& channel = channels[i];
+
+            if (descriptors[i + 1].revents == 0)
+            {
+                continue;
+            }
+
+            auto result = read(channel, buffer, sizeof(buffer));
+
+            if (result < 0 && (errno == EAGAIN || errno == EINTR))
+            {
+                continue;
+            }
+
+            if (result <= 0)
+            {
+                close(channel);
+                channel = -1;
+                continue;
+            }
+
+            consumeOutput(i == 1, buffer, static_cast<std::size_t>(result));
+        }
     }
 
-    return m_exitCode;
+    // Loop may be interrupted by poll failure
+    for (auto fd : {input, channels[0], channels[1]})
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+
+    // Waiting child to end
+    rusage usage{};
+    auto status = wait(usage);
+
+    finish(status, usage);
+}
+
+void CodeExecutor::Process::communicate(IoUring& ring, Launched& launched)
+{
+    enum Operation
+    {
+        Input = 0,
+        Output = 1,
+        Error = 2,
+        Exit = 3
+    };
+
+    // Tag of cancellation completions
+    const uint64_t cancelTag = 4;
+
+    PipeSignalBlocker blocker;
+
+    int descriptors[] = {launched.input, launched.output, launched.error};
+
+    // Kernel writes to this memory until operations
+    // are completed or cancelled
+    thread_local char buffers[2][16384];
+    thread_local siginfo_t info;
+    thread_local ForkServer::Reply reply;
+
+    reply.status = -1;
+    reply.usage = rusage{};
+
+    std::size_t written = 0;
+    bool pending[4] = {false, false, false, false};
+    unsigned cancelling = 0;
+
+    // Exit is awaited by ring too, if it's possible.
+    // Child of fork server reports status to handle.
+    // Host child is reaped by `wait4` after that
+    // to collect used resources.
+    bool ringWait = false;
+
+    if (launched.pid > 0)
+    {
+        ringWait = ring.isSupported(IoUring::WaitIdOpcode);
+    }
+    else
+    {
+        ringWait = launched.waitDescriptor >= 0;
+    }
+
+    // Is status reported by fork server already read
+    bool replied = false;
+
+    bool failed = false;
+
+    auto enqueue = [&](Operation operation)
+    {
+        auto sqe = ring.acquire();
+
+        // Ring has more entries, than operations
+        // of one process and their cancellations,
+        // so it's not expected
+        if (sqe == nullptr)
+        {
+            failed = true;
+            return;
+        }
+
+        sqe->user_data = operation;
+
+        switch (operation)
+        {
+        case Input:
+            sqe->opcode = IORING_OP_WRITE;
+            sqe->fd = descriptors[Input];
+            sqe->addr = reinterpret_cast<uint64_t>(m_inputData->data() + written);
+            sqe->len = static_cast<uint32_t>(
+                std::min<std::size_t>(m_inputData->size() - written, 1u << 30)
+            );
+            break;
+        case Output:
+        case Error:
+            sqe->opcode = IORING_OP_READ;
+            sqe->fd = descriptors[operation];
+            sqe->addr = reinterpret_cast<uint64_t>(buffers[operation - 1]);
+            sqe->len = sizeof(buffers[0]);
+            break;
+        case Exit:
+            if (launched.pid > 0)
+            {
+                sqe->opcode = IoUring::WaitIdOpcode;
+                sqe->fd = launched.pid;
+                sqe->len = P_PID;
+                sqe->file_index = WEXITED | WNOWAIT;
+                sqe->addr2 = reinterpret_cast<uint64_t>(&info);
+            }
+            else
+            {
+                sqe->opcode = IORING_OP_READ;
+                sqe->fd = launched.waitDescriptor;
+                sqe->addr = reinterpret_cast<uint64_t>(&reply);
+                sqe->len = sizeof(reply);
+            }
+            break;
+        }
+
+        pending[operation] = true;
+    };
+
+    auto release = [&](Operation operation)
+    {
+        close(descriptors[operation]);
+        descriptors[operation] = -1;
+    };
+
+    auto complete = [&](const io_uring_cqe& cqe)
+    {
+        if (cqe.user_data == cancelTag)
+        {
+            --cancelling;
+            return;
+        }
+
+        auto operation = static_cast<Operation>(cqe.user_data);
+
+        pending[operation] = false;
+
+        switch (operation)
+        {
+        case Input:
+            if (cqe.res > 0)
+            {
+                written += cqe.res;
+            }
+
+            if (failed ||
+                (cqe.res < 0 && cqe.res != -EAGAIN && cqe.res != -EINTR) ||
+                written == m_inputData->size())
+            {
+                release(Input);
+            }
+            else
+            {
+                enqueue(Input);
+            }
+            break;
+        case Output:
+        case Error:
+            if (cqe.res > 0)
+            {
+                consumeOutput(
+                    operation == Error,
+                    buffers[operation - 1],
+                    static_cast<std::size_t>(cqe.res)
+                );
+            }
+
+            // Nothing is resubmitted, while
+            // operations are cancelled
+            if (failed)
+            {
+                break;
+            }
+
+            if (cqe.res > 0 || cqe.res == -EAGAIN || cqe.res == -EINTR)
+            {
+                enqueue(operation);
+            }
+            else
+            {
+                release(operation);
+            }
+            break;
+        case Exit:
+            if (launched.pid > 0)
+            {
+                // Child is reaped by common way, status
+                // is known only after it
+                break;
+            }
+
+            // Cancelled read has consumed nothing, then
+            // status is read by common way
+            if (cqe.res == -ECANCELED)
+            {
+                break;
+            }
+
+            if (cqe.res != sizeof(reply))
+            {
+                reply.status = -1;
+            }
+
+            close(launched.waitDescriptor);
+            launched.waitDescriptor = -1;
+
+            replied = true;
+            break;
+        }
+    };
+
+    auto isPending = [&]()
+    {
+        return pending[Input] || pending[Output] || pending[Error] || pending[Exit];
+    };
+
+    if (m_inputData->empty())
+    {
+        // Closing stdin, to force EOF
+        release(Input);
+    }
+    else
+    {
+        enqueue(Input);
+    }
+
+    enqueue(Output);
+    enqueue(Error);
+
+    if (ringWait)
+    {
+        enqueue(Exit);
+    }
+
+    while (!failed && isPending())
+    {
+        // Resubmissions are sent together with
+        // waiting for next completion
+        auto result = ring.submit(1);
+
+        // Completion queue is full, it's drained below
+        if (result < 0 && result != -EBUSY && result != -EAGAIN)
+        {
+            failed = true;
+            break;
+        }
+
+        io_uring_cqe cqe;
+
+        while (ring.pop(cqe))
+        {
+            complete(cqe);
+        }
+    }
+
+    if (failed)
+    {
+        // Operations in flight still use buffers and
+        // input data, and their completions must not
+        // reach next process of this thread's ring.
+        // So they are cancelled and drained.
+        for (auto operation : {Input, Output, Error, Exit})
+        {
+            if (!pending[operation])
+            {
+                continue;
+            }
+
+            auto sqe = ring.acquire();
+
+            if (sqe == nullptr)
+            {
+                break;
+            }
+
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->addr = operation;
+            sqe->user_data = cancelTag;
+
+            ++cancelling;
+        }
+
+        while (isPending() || cancelling > 0)
+        {
+            auto result = ring.submit(1);
+
+            if (result < 0 && result != -EBUSY && result != -EAGAIN)
+            {
+                // Ring is unusable. It's destroyed, what
+                // cancels everything, and input data is
+                // kept by it, because kernel may
+                // still read it.
+                IoUring::resetLocal(m_inputData);
+                break;
+            }
+
+            io_uring_cqe cqe;
+
+            while (ring.pop(cqe))
+            {
+                complete(cqe);
+            }
+        }
+    }
+
+    auto wait = launched.wait;
+
+    if (replied)
+    {
+        wait = [](rusage& usage)
+        {
+            usage = reply.usage;
+            return reply.status;
+        };
+    }
+
+    if (failed)
+    {
+        // Rest of input and output is passed by poll
+        communicate(
+            descriptors[Input],
+            descriptors[Output],
+            descriptors[Error],
+            written,
+            wait
+        );
+
+        return;
+    }
+
+    rusage usage{};
+    auto status = wait(usage);
+
+    finish(status, usage);
+}
+
+ssize_t CodeExecutor::Process::writeInput(int fd, std::size_t offset)
+{
+    iovec chunk{};
+    chunk.iov_base = const_cast<char*>(m_inputData->data() + offset);
+    chunk.iov_len = m_inputData->size() - offset;
+
+    // Pipe references pages of buffer instead of
+    // copying them. Buffer is immutable and it's
+    // kept alive by process.
+    auto result = vmsplice(fd, &chunk, 1, SPLICE_F_NONBLOCK);
+
+    if (result < 0 && (errno == EINVAL || errno == ENOSYS || errno == EBADF))
+    {
+        result = write(fd, chunk.iov_base, chunk.iov_len);
+    }
+
+    return result;
 }
 
 bool CodeExecutor::Process::makeNonBlocking(int fd)
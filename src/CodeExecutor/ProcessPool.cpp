@@ -0,0 +1,495 @@
+#include <cerrno>
+#include <csignal>
+#include <stdexcept>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "CodeExecutor/ProcessPool.hpp"
+
+namespace
+{
+    enum Kind
+    {
+        Input = 0,
+        Output = 1,
+        Error = 2,
+        Exit = 3
+    };
+}
+
+CodeExecutor::ProcessPool::ProcessPool() :
+    m_epoll(-1),
+    m_wakeup(-1),
+    m_mutex(),
+    m_pending(),
+    m_stopping(false),
+    m_running(0),
+    m_entries(),
+    m_thread()
+{
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+
+    if (m_epoll < 0)
+    {
+        throw std::runtime_error("Can't create epoll instance");
+    }
+
+    m_wakeup = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+    if (m_wakeup < 0)
+    {
+        close(m_epoll);
+        throw std::runtime_error("Can't create eventfd");
+    }
+
+    // Watch without entry is wakeup event
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeup, &event);
+
+    m_thread = std::thread(&ProcessPool::run, this);
+}
+
+CodeExecutor::ProcessPool::~ProcessPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_stopping = true;
+    }
+
+    uint64_t value = 1;
+    write(m_wakeup, &value, sizeof(value));
+
+    m_thread.join();
+
+    close(m_wakeup);
+    close(m_epoll);
+}
+
+std::future<int> CodeExecutor::ProcessPool::launch(ProcessPtr process)
+{
+    auto promise = std::make_shared<std::promise<int>>();
+    auto future = promise->get_future();
+
+    launch(
+        std::move(process),
+        [promise](const ProcessPtr& process)
+        {
+            promise->set_value(process->exitCode());
+        }
+    );
+
+    return future;
+}
+
+void CodeExecutor::ProcessPool::launch(ProcessPtr process, Callback callback)
+{
+    std::unique_ptr<Entry> entry(new Entry());
+
+    entry->process = std::move(process);
+    entry->callback = std::move(callback);
+    entry->written = 0;
+    entry->exited = false;
+    entry->reaped = false;
+    entry->status = -1;
+    entry->usage = rusage{};
+
+    // Exit code is already set, if process
+    // can't be spawned
+    if (!entry->process->launch(entry->launched, true))
+    {
+        try
+        {
+            entry->callback(entry->process);
+        }
+        catch (...)
+        {
+            // Same as for callbacks, called by reactor
+        }
+
+        return;
+    }
+
+    for (int kind = Input; kind <= Exit; ++kind)
+    {
+        entry->watches[kind] = {entry.get(), kind};
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (!m_stopping)
+        {
+            ++m_running;
+
+            m_pending.push_back(std::move(entry));
+        }
+    }
+
+    // Reactor is stopped, process is
+    // handled by calling thread
+    if (entry)
+    {
+        auto& launched = entry->launched;
+
+        entry->process->communicate(
+            launched.input,
+            launched.output,
+            launched.error,
+            0,
+            launched.wait
+        );
+
+        try
+        {
+            entry->callback(entry->process);
+        }
+        catch (...)
+        {
+            // Same as for callbacks, called by reactor
+        }
+
+        return;
+    }
+
+    uint64_t value = 1;
+    write(m_wakeup, &value, sizeof(value));
+}
+
+std::size_t CodeExecutor::ProcessPool::running() const
+{
+    return m_running;
+}
+
+void CodeExecutor::ProcessPool::run()
+{
+    // Children may exit without reading input.
+    // SIGPIPE stays pending for this thread only.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    epoll_event events[64];
+
+    // Children without wait descriptor are
+    // checked periodically after outputs close
+    bool reaping = false;
+
+    while (true)
+    {
+        auto count = epoll_wait(m_epoll, events, 64, reaping ? 10 : -1);
+
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            // Reactor can't work, processes are
+            // finished by blocking waits
+            count = 0;
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            m_stopping = true;
+        }
+
+        for (int i = 0; i < count; ++i)
+        {
+            if (events[i].data.ptr == nullptr)
+            {
+                uint64_t value;
+                read(m_wakeup, &value, sizeof(value));
+
+                continue;
+            }
+
+            handle(*static_cast<Watch*>(events[i].data.ptr));
+        }
+
+        // Entries are destroyed after all events are
+        // handled, events may refer to them
+        std::vector<Entry*> completed;
+
+        reaping = false;
+
+        for (auto&& entry : m_entries)
+        {
+            auto& launched = entry.second->launched;
+
+            if (launched.output >= 0 || launched.error >= 0)
+            {
+                continue;
+            }
+
+            if (launched.waitDescriptor >= 0 && !entry.second->exited)
+            {
+                continue;
+            }
+
+            // Child may keep running after closing
+            // outputs, reactor must not block on it
+            if (launched.waitDescriptor < 0 && !reap(*entry.second))
+            {
+                reaping = true;
+                continue;
+            }
+
+            completed.push_back(entry.first);
+        }
+
+        for (auto entry : completed)
+        {
+            complete(*entry);
+
+            m_entries.erase(entry);
+        }
+
+        std::vector<std::unique_ptr<Entry>> pending;
+        bool stopping;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            pending.swap(m_pending);
+            stopping = m_stopping;
+        }
+
+        for (auto&& entry : pending)
+        {
+            add(std::move(entry));
+        }
+
+        if (stopping && count == 0 && !m_entries.empty())
+        {
+            // Epoll failed, remaining processes
+            // are waited without it
+            for (auto&& entry : m_entries)
+            {
+                auto& launched = entry.second->launched;
+
+                release(launched.output);
+                release(launched.error);
+
+                complete(*entry.second);
+            }
+
+            m_entries.clear();
+        }
+
+        if (stopping && m_entries.empty() && pending.empty())
+        {
+            return;
+        }
+    }
+}
+
+void CodeExecutor::ProcessPool::add(std::unique_ptr<Entry> entry)
+{
+    auto& launched = entry->launched;
+
+    if (entry->process->m_inputData->empty())
+    {
+        // Closing stdin, to force EOF
+        close(launched.input);
+        launched.input = -1;
+    }
+
+    int descriptors[] = {
+        launched.input,
+        launched.output,
+        launched.error,
+        launched.waitDescriptor
+    };
+
+    for (int kind = Input; kind <= Exit; ++kind)
+    {
+        if (descriptors[kind] < 0)
+        {
+            continue;
+        }
+
+        if (kind != Exit)
+        {
+            entry->process->makeNonBlocking(descriptors[kind]);
+        }
+
+        epoll_event event = {};
+        event.events = kind == Input ? EPOLLOUT : EPOLLIN;
+        event.data.ptr = &entry->watches[kind];
+
+        epoll_ctl(m_epoll, EPOLL_CTL_ADD, descriptors[kind], &event);
+    }
+
+    auto pointer = entry.get();
+
+    m_entries.emplace(pointer, std::move(entry));
+}
+
+void CodeExecutor::ProcessPool::handle(Watch& watch)
+{
+    auto& entry = *watch.entry;
+    auto& launched = entry.launched;
+
+    switch (watch.kind)
+    {
+    case Input:
+    {
+        if (launched.input < 0)
+        {
+            return;
+        }
+
+        auto& data = *entry.process->m_inputData;
+
+        auto result = entry.process->writeInput(launched.input, entry.written);
+
+        if (result > 0)
+        {
+            entry.written += result;
+        }
+
+        if ((result < 0 && errno != EAGAIN && errno != EINTR) ||
+            entry.written == data.size())
+        {
+            release(launched.input);
+        }
+
+        return;
+    }
+    case Output:
+    case Error:
+    {
+        auto& fd = watch.kind == Output ? launched.output : launched.error;
+
+        if (fd < 0)
+        {
+            return;
+        }
+
+        char buffer[16384];
+
+        auto result = read(fd, buffer, sizeof(buffer));
+
+        if (result < 0 && (errno == EAGAIN || errno == EINTR))
+        {
+            return;
+        }
+
+        if (result <= 0)
+        {
+            release(fd);
+            return;
+        }
+
+        entry.process->consumeOutput(
+            watch.kind == Error,
+            buffer,
+            static_cast<std::size_t>(result)
+        );
+
+        return;
+    }
+    case Exit:
+    {
+        if (entry.exited)
+        {
+            return;
+        }
+
+        // Descriptor is released by wait function
+        epoll_ctl(m_epoll, EPOLL_CTL_DEL, launched.waitDescriptor, nullptr);
+        entry.exited = true;
+
+        return;
+    }
+    default:
+        return;
+    }
+}
+
+void CodeExecutor::ProcessPool::release(int& fd)
+{
+    if (fd < 0)
+    {
+        return;
+    }
+
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+
+    fd = -1;
+}
+
+bool CodeExecutor::ProcessPool::reap(Entry& entry)
+{
+    // Only host children can be waited directly,
+    // others are waited by common way
+    if (entry.launched.pid <= 0)
+    {
+        return true;
+    }
+
+    while (true)
+    {
+        auto result = wait4(entry.launched.pid, &entry.status, WNOHANG, &entry.usage);
+
+        if (result == 0)
+        {
+            return false;
+        }
+
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (result < 0)
+        {
+            entry.status = -1;
+        }
+
+        entry.reaped = true;
+
+        return true;
+    }
+}
+
+void CodeExecutor::ProcessPool::complete(Entry& entry)
+{
+    auto& launched = entry.launched;
+
+    release(launched.input);
+
+    if (!entry.exited && launched.waitDescriptor >= 0)
+    {
+        epoll_ctl(m_epoll, EPOLL_CTL_DEL, launched.waitDescriptor, nullptr);
+    }
+
+    if (!entry.reaped)
+    {
+        // Child has already exited, or
+        // reactor is stopped
+        entry.status = launched.wait(entry.usage);
+    }
+
+    entry.process->finish(entry.status, entry.usage);
+
+    --m_running;
+
+    try
+    {
+        entry.callback(entry.process);
+    }
+    catch (...)
+    {
+        // Reactor must survive callback errors
+    }
+}
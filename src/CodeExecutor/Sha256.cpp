@@ -0,0 +1,340 @@
+#include <algorithm>
+#include "CodeExecutor/Sha256.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define CODEEXECUTOR_SHA_NI
+#endif
+
+static const std::uint32_t roundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static inline std::uint32_t rotateRight(std::uint32_t value, int bits)
+{
+    return (value >> bits) | (value << (32 - bits));
+}
+
+#ifdef CODEEXECUTOR_SHA_NI
+/**
+ * @brief Function for checking if CPU has
+ * SHA extensions, used by `processBlocksShaNi`.
+ * @return Are extensions available.
+ */
+static bool hasShaExtensions()
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) ||
+        !(ecx & bit_SSSE3) ||
+        !(ecx & bit_SSE4_1))
+    {
+        return false;
+    }
+
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+    {
+        return false;
+    }
+
+    return (ebx & bit_SHA) != 0;
+}
+
+/**
+ * @brief Function for processing blocks with
+ * SHA extensions. Every 4 rounds are performed
+ * by 2 instructions, message schedule is
+ * calculated by `sha256msg1`/`sha256msg2`.
+ * @param state Hash state.
+ * @param data Blocks.
+ * @param count Number of blocks.
+ */
+__attribute__((target("sha,sse4.1,ssse3")))
+static void processBlocksShaNi(std::uint32_t* state,
+                               const std::uint8_t* data,
+                               std::size_t count)
+{
+    // Reverses bytes of every 32 bit word
+    const __m128i byteSwap = _mm_set_epi64x(
+        0x0c0d0e0f08090a0bULL,
+        0x0405060700010203ULL
+    );
+
+    // Instructions use ABEF/CDGH state layout
+    auto temp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[0]));
+    auto state1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[4]));
+
+    temp = _mm_shuffle_epi32(temp, 0xB1);
+    state1 = _mm_shuffle_epi32(state1, 0x1B);
+
+    auto state0 = _mm_alignr_epi8(temp, state1, 8);
+    state1 = _mm_blend_epi16(state1, temp, 0xF0);
+
+    for (; count > 0; --count, data += 64)
+    {
+        auto savedState0 = state0;
+        auto savedState1 = state1;
+
+        __m128i messages[4];
+
+        for (int i = 0; i < 4; ++i)
+        {
+            messages[i] = _mm_shuffle_epi8(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 16)),
+                byteSwap
+            );
+        }
+
+        for (int group = 0; group < 16; ++group)
+        {
+            auto& current = messages[group % 4];
+            auto& previous = messages[(group + 3) % 4];
+            auto& next = messages[(group + 1) % 4];
+
+            auto message = _mm_add_epi32(
+                current,
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(&roundConstants[group * 4]))
+            );
+
+            state1 = _mm_sha256rnds2_epu32(state1, state0, message);
+
+            // Words of next group are finished
+            if (group >= 3 && group < 15)
+            {
+                next = _mm_add_epi32(next, _mm_alignr_epi8(current, previous, 4));
+                next = _mm_sha256msg2_epu32(next, current);
+            }
+
+            message = _mm_shuffle_epi32(message, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, message);
+
+            // Words of group after 3 groups are started
+            if (group >= 1 && group < 13)
+            {
+                previous = _mm_sha256msg1_epu32(previous, current);
+            }
+        }
+
+        state0 = _mm_add_epi32(state0, savedState0);
+        state1 = _mm_add_epi32(state1, savedState1);
+    }
+
+    temp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(temp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, temp, 8);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[0]), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[4]), state1);
+}
+#endif
+
+CodeExecutor::Sha256::Sha256() :
+    m_state({
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    }),
+    m_buffer(),
+    m_bufferSize(0),
+    m_length(0)
+{
+
+}
+
+void CodeExecutor::Sha256::update(const void* data, std::size_t size)
+{
+    auto bytes = static_cast<const std::uint8_t*>(data);
+
+    m_length += size;
+
+    // Filling partial block first
+    if (m_bufferSize > 0)
+    {
+        auto count = std::min(size, m_buffer.size() - m_bufferSize);
+
+        std::copy(bytes, bytes + count, m_buffer.begin() + m_bufferSize);
+
+        m_bufferSize += count;
+        bytes += count;
+        size -= count;
+
+        if (m_bufferSize < m_buffer.size())
+        {
+            return;
+        }
+
+        processBlocks(m_buffer.data(), 1);
+        m_bufferSize = 0;
+    }
+
+    // Processing full blocks without copying
+    auto blocks = size / m_buffer.size();
+
+    if (blocks > 0)
+    {
+        processBlocks(bytes, blocks);
+
+        bytes += blocks * m_buffer.size();
+        size -= blocks * m_buffer.size();
+    }
+
+    std::copy(bytes, bytes + size, m_buffer.begin());
+    m_bufferSize = size;
+}
+
+void CodeExecutor::Sha256::update(const std::string& data)
+{
+    update(data.data(), data.size());
+}
+
+CodeExecutor::Sha256::Digest CodeExecutor::Sha256::digest()
+{
+    auto bitLength = m_length * 8;
+
+    // Padding: 0x80, zeroes and message length in bits
+    std::uint8_t padding[72] = {0x80};
+
+    auto paddingSize = (m_bufferSize < 56 ? 56 : 120) - m_bufferSize;
+
+    for (int i = 0; i < 8; ++i)
+    {
+        padding[paddingSize + i] = static_cast<std::uint8_t>(bitLength >> (56 - 8 * i));
+    }
+
+    update(padding, paddingSize + 8);
+
+    Digest result;
+
+    for (std::size_t i = 0; i < m_state.size(); ++i)
+    {
+        result[i * 4 + 0] = static_cast<std::uint8_t>(m_state[i] >> 24);
+        result[i * 4 + 1] = static_cast<std::uint8_t>(m_state[i] >> 16);
+        result[i * 4 + 2] = static_cast<std::uint8_t>(m_state[i] >> 8);
+        result[i * 4 + 3] = static_cast<std::uint8_t>(m_state[i]);
+    }
+
+    return result;
+}
+
+std::string CodeExecutor::Sha256::hexDigest()
+{
+    return toHex(digest());
+}
+
+std::string CodeExecutor::Sha256::hash(const std::string& data)
+{
+    Sha256 sha;
+
+    sha.update(data);
+
+    return sha.hexDigest();
+}
+
+std::string CodeExecutor::Sha256::toHex(const Digest& digest)
+{
+    static const char alphabet[] = "0123456789abcdef";
+
+    std::string result;
+    result.reserve(digest.size() * 2);
+
+    for (auto byte : digest)
+    {
+        result.push_back(alphabet[byte >> 4]);
+        result.push_back(alphabet[byte & 0x0F]);
+    }
+
+    return result;
+}
+
+bool CodeExecutor::Sha256::isAccelerated()
+{
+#ifdef CODEEXECUTOR_SHA_NI
+    static const bool accelerated = hasShaExtensions();
+
+    return accelerated;
+#else
+    return false;
+#endif
+}
+
+void CodeExecutor::Sha256::processBlocks(const std::uint8_t* blocks, std::size_t count)
+{
+#ifdef CODEEXECUTOR_SHA_NI
+    if (isAccelerated())
+    {
+        processBlocksShaNi(m_state.data(), blocks, count);
+        return;
+    }
+#endif
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        processBlock(blocks + i * 64);
+    }
+}
+
+void CodeExecutor::Sha256::processBlock(const std::uint8_t* block)
+{
+    std::uint32_t w[64];
+
+    for (int i = 0; i < 16; ++i)
+    {
+        w[i] = (std::uint32_t(block[i * 4 + 0]) << 24) |
+               (std::uint32_t(block[i * 4 + 1]) << 16) |
+               (std::uint32_t(block[i * 4 + 2]) << 8) |
+               (std::uint32_t(block[i * 4 + 3]));
+    }
+
+    for (int i = 16; i < 64; ++i)
+    {
+        auto s0 = rotateRight(w[i - 15], 7) ^ rotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        auto s1 = rotateRight(w[i - 2], 17) ^ rotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    auto a = m_state[0];
+    auto b = m_state[1];
+    auto c = m_state[2];
+    auto d = m_state[3];
+    auto e = m_state[4];
+    auto f = m_state[5];
+    auto g = m_state[6];
+    auto h = m_state[7];
+
+    for (int i = 0; i < 64; ++i)
+    {
+        auto s1 = rotateRight(e, 6) ^ rotateRight(e, 11) ^ rotateRight(e, 25);
+        auto choice = (e & f) ^ (~e & g);
+        auto temp1 = h + s1 + choice + roundConstants[i] + w[i];
+        auto s0 = rotateRight(a, 2) ^ rotateRight(a, 13) ^ rotateRight(a, 22);
+        auto majority = (a & b) ^ (a & c) ^ (b & c);
+        auto temp2 = s0 + majority;
+
+        h = g;
+        g = f;
+        f = e;
+        e = d + temp1;
+        d = c;
+        c = b;
+        b = a;
+        a = temp1 + temp2;
+    }
+
+    m_state[0] += a;
+    m_state[1] += b;
+    m_state[2] += c;
+    m_state[3] += d;
+    m_state[4] += e;
+    m_state[5] += f;
+    m_state[6] += g;
+    m_state[7] += h;
+}
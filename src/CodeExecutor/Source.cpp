@@ -1,19 +1,63 @@
 #include "CodeExecutor/Source.hpp"
+#include "CodeExecutor/Sha256.hpp"
 
 CodeExecutor::SourcePtr CodeExecutor::Source::createFromSource(std::string content)
 {
+    return createFromBuffer(
+        std::make_shared<const std::string>(std::move(content))
+    );
+}
+
+CodeExecutor::SourcePtr CodeExecutor::Source::createFromBuffer(std::shared_ptr<const std::string> content)
+{
+    if (!content)
+    {
+        content = std::make_shared<const std::string>();
+    }
+
     auto source = std::make_shared<Source>(std::move(content), HideArg());
 
     return source;
 }
 
-std::string CodeExecutor::Source::content() const
+const std::string& CodeExecutor::Source::content() const
+{
+    return *m_content;
+}
+
+std::string_view CodeExecutor::Source::contentView() const
+{
+    return *m_content;
+}
+
+std::shared_ptr<const std::string> CodeExecutor::Source::buffer() const
 {
     return m_content;
 }
 
-CodeExecutor::Source::Source(std::string content, HideArg) :
-    m_content(std::move(content))
+std::size_t CodeExecutor::Source::size() const
+{
+    return m_content->size();
+}
+
+const std::string& CodeExecutor::Source::fingerprint() const
+{
+    // Content is immutable, so it's hashed once
+    std::call_once(
+        m_fingerprintFlag,
+        [this]()
+        {
+            m_fingerprint = Sha256::hash(*m_content);
+        }
+    );
+
+    return m_fingerprint;
+}
+
+CodeExecutor::Source::Source(std::shared_ptr<const std::string> content, HideArg) :
+    m_content(std::move(content)),
+    m_fingerprintFlag(),
+    m_fingerprint()
 {
 
 }
@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <mutex>
+#include "CodeExecutor/SymbolRegistry.hpp"
+
+CodeExecutor::SymbolRegistry::SymbolRegistry() :
+    m_mutex(),
+    m_symbols(),
+    m_owned()
+{
+
+}
+
+std::size_t CodeExecutor::SymbolRegistry::add(const CodeExecutor::LibraryPtr& library)
+{
+    if (!library || !library->isLoaded())
+    {
+        return 0;
+    }
+
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+        if (m_owned.count(library.get()) != 0)
+        {
+            return 0;
+        }
+    }
+
+    // Symbols are resolved by library, so they
+    // are cached there for direct lookups too
+    auto names = library->symbols();
+    auto addresses = library->resolveAll(names);
+
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+    // Library could be added by other
+    // thread, while symbols were resolved
+    if (m_owned.count(library.get()) != 0)
+    {
+        return 0;
+    }
+
+    {
+        std::unique_lock<std::shared_mutex> libraryLock(library->m_symbolsMutex);
+
+        library->m_registries.push_back(weak_from_this());
+    }
+
+    auto& owned = m_owned[library.get()];
+
+    for (std::size_t i = 0; i < names.size(); ++i)
+    {
+        if (addresses[i] == nullptr)
+        {
+            continue;
+        }
+
+        m_symbols[names[i]].push_back({library.get(), library, addresses[i]});
+
+        owned.push_back(std::move(names[i]));
+    }
+
+    return owned.size();
+}
+
+void CodeExecutor::SymbolRegistry::remove(const CodeExecutor::Library* library)
+{
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+    auto owned = m_owned.find(library);
+
+    if (owned == m_owned.end())
+    {
+        return;
+    }
+
+    for (auto&& name : owned->second)
+    {
+        auto found = m_symbols.find(name);
+
+        if (found == m_symbols.end())
+        {
+            continue;
+        }
+
+        // Previous owner becomes visible again
+        auto& owners = found->second;
+
+        owners.erase(
+            std::remove_if(
+                owners.begin(),
+                owners.end(),
+                [library](const Entry& entry)
+                {
+                    return entry.owner == library;
+                }
+            ),
+            owners.end()
+        );
+
+        if (owners.empty())
+        {
+            m_symbols.erase(found);
+        }
+    }
+
+    m_owned.erase(owned);
+}
+
+CodeExecutor::SymbolRegistry::Symbol CodeExecutor::SymbolRegistry::find(const std::string& name) const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+    auto found = m_symbols.find(name);
+
+    if (found == m_symbols.end())
+    {
+        return {nullptr, nullptr};
+    }
+
+    // Library may be destroyed, but not removed
+    // yet, then previous owner is used
+    for (auto entry = found->second.rbegin(); entry != found->second.rend(); ++entry)
+    {
+        if (auto library = entry->library.lock())
+        {
+            return {std::move(library), entry->address};
+        }
+    }
+
+    return {nullptr, nullptr};
+}
+
+std::size_t CodeExecutor::SymbolRegistry::size() const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+    return m_symbols.size();
+}
+
+CodeExecutor::SymbolRegistryPtr CodeExecutor::SymbolRegistry::global()
+{
+    static auto registry = std::make_shared<SymbolRegistry>();
+
+    return registry;
+}
@@ -0,0 +1,123 @@
+#include <stdexcept>
+#include "CodeExecutor/TieredLibrary.hpp"
+
+CodeExecutor::TieredLibrary::TieredLibrary(CodeExecutor::LibraryPtr library) :
+    m_mutex(),
+    m_condition(),
+    m_libraries({std::move(library)}),
+    m_slots(),
+    m_optimized(false),
+    m_finished(false),
+    m_error()
+{
+
+}
+
+CodeExecutor::LibraryPtr CodeExecutor::TieredLibrary::library() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_libraries.back();
+}
+
+bool CodeExecutor::TieredLibrary::isOptimized() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_optimized;
+}
+
+bool CodeExecutor::TieredLibrary::waitOptimized() const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    m_condition.wait(
+        lock,
+        [this]()
+        {
+            return m_finished;
+        }
+    );
+
+    return m_optimized;
+}
+
+std::exception_ptr CodeExecutor::TieredLibrary::optimizationError() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_error;
+}
+
+void CodeExecutor::TieredLibrary::promote(CodeExecutor::LibraryPtr library)
+{
+    // Linker doesn't throw, if library can't be loaded
+    if (!library || !library->isLoaded())
+    {
+        fail(std::make_exception_ptr(std::runtime_error(
+            library ? library->errorString() : "No optimized library"
+        )));
+
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (auto&& slot : m_slots)
+        {
+            slot.second.publish(library);
+        }
+
+        // Previous builds stay loaded, because
+        // their functions may still be running
+        m_libraries.push_back(std::move(library));
+
+        m_optimized = true;
+        m_finished = true;
+    }
+
+    m_condition.notify_all();
+}
+
+void CodeExecutor::TieredLibrary::fail(std::exception_ptr error)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_error = std::move(error);
+        m_finished = true;
+    }
+
+    m_condition.notify_all();
+}
+
+std::shared_ptr<void> CodeExecutor::TieredLibrary::slot(const char* name,
+                                                         std::type_index type,
+                                                         const SlotFactory& factory)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto key = std::make_pair(std::string(name), type);
+
+    auto found = m_slots.find(key);
+
+    if (found != m_slots.end())
+    {
+        return found->second.function;
+    }
+
+    auto slot = factory(name);
+
+    // Symbol is taken from the best build,
+    // that has it
+    for (auto library = m_libraries.rbegin(); library != m_libraries.rend(); ++library)
+    {
+        if (slot.publish(*library))
+        {
+            return m_slots.emplace(std::move(key), std::move(slot)).first->second.function;
+        }
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,396 @@
+#include <algorithm>
+#include <cctype>
+#include "CodeExecutor/UnityBatcher.hpp"
+
+namespace
+{
+    struct Token
+    {
+        std::string text;
+        bool identifier;
+    };
+
+    const std::unordered_set<std::string> keywords = {
+        "alignas", "alignof", "asm", "auto", "bool", "break", "case", "catch",
+        "char", "char8_t", "char16_t", "char32_t", "class", "const", "consteval",
+        "constexpr", "constinit", "const_cast", "continue", "decltype", "default",
+        "delete", "do", "double", "dynamic_cast", "else", "enum", "explicit",
+        "export", "extern", "false", "final", "float", "for", "friend", "goto",
+        "if", "inline", "int", "long", "mutable", "namespace", "new", "noexcept",
+        "nullptr", "operator", "override", "private", "protected", "public",
+        "register", "reinterpret_cast", "return", "short", "signed", "sizeof",
+        "static", "static_assert", "static_cast", "struct", "switch", "template",
+        "this", "thread_local", "throw", "true", "try", "typedef", "typeid",
+        "typename", "union", "unsigned", "using", "virtual", "void", "volatile",
+        "wchar_t", "while"
+    };
+
+    bool isIdentifierStart(char c)
+    {
+        return std::isalpha(static_cast<unsigned char>(c)) || c == '_';
+    }
+
+    bool isIdentifierChar(char c)
+    {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+    }
+
+    /**
+     * @brief Function for splitting source into
+     * tokens. Comments, literals contents and
+     * preprocessor directives are skipped, names
+     * of defined macros are collected.
+     */
+    std::vector<Token> tokenize(const std::string& content,
+                                std::vector<std::string>* macros)
+    {
+        std::vector<Token> tokens;
+
+        bool lineStart = true;
+        std::size_t i = 0;
+
+        while (i < content.size())
+        {
+            auto c = content[i];
+
+            if (c == '\n')
+            {
+                lineStart = true;
+                ++i;
+                continue;
+            }
+
+            if (std::isspace(static_cast<unsigned char>(c)))
+            {
+                ++i;
+                continue;
+            }
+
+            // Comments
+            if (c == '/' && i + 1 < content.size() && content[i + 1] == '/')
+            {
+                i = content.find('\n', i);
+                i = i == std::string::npos ? content.size() : i;
+                continue;
+            }
+
+            if (c == '/' && i + 1 < content.size() && content[i + 1] == '*')
+            {
+                i = content.find("*/", i + 2);
+                i = i == std::string::npos ? content.size() : i + 2;
+                continue;
+            }
+
+            // Preprocessor directive with line continuations
+            if (c == '#' && lineStart)
+            {
+                auto end = i;
+
+                while (true)
+                {
+                    end = content.find('\n', end);
+
+                    if (end == std::string::npos)
+                    {
+                        end = content.size();
+                        break;
+                    }
+
+                    if (end > 0 && content[end - 1] == '\\')
+                    {
+                        ++end;
+                        continue;
+                    }
+
+                    break;
+                }
+
+                if (macros)
+                {
+                    auto position = content.find_first_not_of(" \t", i + 1);
+
+                    if (position != std::string::npos &&
+                        content.compare(position, 6, "define") == 0)
+                    {
+                        position = content.find_first_not_of(" \t", position + 6);
+
+                        auto nameEnd = position;
+
+                        while (nameEnd < end && isIdentifierChar(content[nameEnd]))
+                        {
+                            ++nameEnd;
+                        }
+
+                        if (nameEnd > position)
+                        {
+                            macros->push_back(content.substr(position, nameEnd - position));
+                        }
+                    }
+                }
+
+                i = end;
+                continue;
+            }
+
+            lineStart = false;
+
+            // Raw string literal
+            if (c == 'R' && i + 1 < content.size() && content[i + 1] == '"')
+            {
+                auto open = content.find('(', i + 2);
+
+                if (open != std::string::npos)
+                {
+                    auto terminator = ")" + content.substr(i + 2, open - i - 2) + "\"";
+                    auto close = content.find(terminator, open);
+
+                    i = close == std::string::npos ? content.size() : close + terminator.size();
+
+                    tokens.push_back({"\"", false});
+                    continue;
+                }
+            }
+
+            if (isIdentifierStart(c))
+            {
+                auto end = i;
+
+                while (end < content.size() && isIdentifierChar(content[end]))
+                {
+                    ++end;
+                }
+
+                tokens.push_back({content.substr(i, end - i), true});
+
+                i = end;
+                continue;
+            }
+
+            if (std::isdigit(static_cast<unsigned char>(c)))
+            {
+                while (i < content.size() &&
+                       (isIdentifierChar(content[i]) || content[i] == '.' || content[i] == '\''))
+                {
+                    ++i;
+                }
+
+                tokens.push_back({"0", false});
+                continue;
+            }
+
+            // String and character literals
+            if (c == '"' || c == '\'')
+            {
+                ++i;
+
+                while (i < content.size() && content[i] != c)
+                {
+                    i += content[i] == '\\' ? 2 : 1;
+                }
+
+                ++i;
+
+                tokens.push_back({std::string(1, c), false});
+                continue;
+            }
+
+            if (c == ':' && i + 1 < content.size() && content[i + 1] == ':')
+            {
+                tokens.push_back({"::", false});
+
+                i += 2;
+                continue;
+            }
+
+            tokens.push_back({std::string(1, c), false});
+            ++i;
+        }
+
+        return tokens;
+    }
+}
+
+CodeExecutor::UnityBatcher::UnityBatcher(std::size_t batchSize) :
+    m_batchSize(std::max<std::size_t>(batchSize, 1))
+{
+
+}
+
+CodeExecutor::UnityBatcher::BatchesContainer
+CodeExecutor::UnityBatcher::batch(const std::vector<SourcePtr>& sources) const
+{
+    BatchesContainer batches;
+    std::vector<NamesContainer> batchNames;
+
+    for (std::size_t i = 0; i < sources.size(); ++i)
+    {
+        auto names = declaredNames(sources[i]->content());
+
+        auto batch = std::find_if(
+            batches.begin(),
+            batches.end(),
+            [&](const BatchContainer& candidate)
+            {
+                if (candidate.size() >= m_batchSize)
+                {
+                    return false;
+                }
+
+                auto& candidateNames = batchNames[&candidate - batches.data()];
+
+                return std::none_of(
+                    names.begin(),
+                    names.end(),
+                    [&candidateNames](const std::string& name)
+                    {
+                        return candidateNames.count(name) > 0;
+                    }
+                );
+            }
+        );
+
+        if (batch == batches.end())
+        {
+            batches.emplace_back();
+            batchNames.emplace_back();
+
+            batch = std::prev(batches.end());
+        }
+
+        batch->push_back(i);
+        batchNames[batch - batches.begin()].insert(names.begin(), names.end());
+    }
+
+    return batches;
+}
+
+CodeExecutor::SourcePtr CodeExecutor::UnityBatcher::merge(const std::vector<SourcePtr>& sources,
+                                                          const std::vector<std::string>& names)
+{
+    std::string content;
+    std::size_t size = 0;
+
+    for (auto&& source : sources)
+    {
+        size += source->size();
+    }
+
+    content.reserve(size + sources.size() * 64);
+
+    for (std::size_t i = 0; i < sources.size(); ++i)
+    {
+        auto& source = sources[i]->content();
+
+        content += "#line 1 \"" + names.at(i) + "\"\n";
+        content += source;
+        content += '\n';
+
+        // Macros of one source must not affect next ones
+        for (auto&& macro : macroNames(source))
+        {
+            content += "#undef " + macro + "\n";
+        }
+    }
+
+    return Source::createFromSource(std::move(content));
+}
+
+CodeExecutor::UnityBatcher::NamesContainer
+CodeExecutor::UnityBatcher::declaredNames(const std::string& content)
+{
+    auto tokens = tokenize(content, nullptr);
+
+    NamesContainer names;
+
+    // `true` for namespaces and linkage specifications,
+    // `false` for classes, functions and initializers
+    std::vector<bool> scopes;
+
+    bool namespaceHead = false;
+    int parenthesesDepth = 0;
+
+    for (std::size_t i = 0; i < tokens.size(); ++i)
+    {
+        auto& token = tokens[i];
+
+        if (token.text == "namespace")
+        {
+            namespaceHead = true;
+            continue;
+        }
+
+        if (token.text == "{")
+        {
+            // `extern "C" {` is linkage specification
+            bool linkage = i >= 2 &&
+                           tokens[i - 1].text == "\"" &&
+                           tokens[i - 2].text == "extern";
+
+            scopes.push_back(namespaceHead || linkage);
+
+            namespaceHead = false;
+            continue;
+        }
+
+        if (token.text == "}")
+        {
+            if (!scopes.empty())
+            {
+                scopes.pop_back();
+            }
+
+            continue;
+        }
+
+        if (token.text == ";")
+        {
+            // Namespace alias
+            namespaceHead = false;
+            continue;
+        }
+
+        if (token.text == "(")
+        {
+            ++parenthesesDepth;
+            continue;
+        }
+
+        if (token.text == ")")
+        {
+            parenthesesDepth = std::max(parenthesesDepth - 1, 0);
+            continue;
+        }
+
+        bool namespaceScope = scopes.empty() || scopes.back();
+
+        if (!token.identifier ||
+            namespaceHead ||
+            !namespaceScope ||
+            parenthesesDepth > 0 ||
+            i + 1 >= tokens.size() ||
+            keywords.count(token.text) > 0)
+        {
+            continue;
+        }
+
+        static const std::unordered_set<std::string> declaratorEnds = {
+            "(", "=", ";", "[", "{", ",", ":"
+        };
+
+        if (declaratorEnds.count(tokens[i + 1].text) > 0)
+        {
+            names.insert(token.text);
+        }
+    }
+
+    return names;
+}
+
+std::vector<std::string> CodeExecutor::UnityBatcher::macroNames(const std::string& content)
+{
+    std::vector<std::string> macros;
+
+    tokenize(content, &macros);
+
+    return macros;
+}
@@ -0,0 +1,107 @@
+#include <stdexcept>
+#include <vector>
+#include <stdlib.h>
+#include <unistd.h>
+#include "CodeExecutor/Workspace.hpp"
+
+struct CodeExecutor::Workspace::Directory
+{
+    explicit Directory(std::filesystem::path path) :
+        path(std::move(path)),
+        files(0)
+    {
+
+    }
+
+    ~Directory()
+    {
+        std::error_code error;
+        std::filesystem::remove_all(path, error);
+    }
+
+    std::filesystem::path path;
+    std::atomic<std::size_t> files;
+};
+
+class CodeExecutor::Workspace::File : public CodeExecutor::Artifact
+{
+public:
+    File(std::shared_ptr<Directory> directory, std::filesystem::path path) :
+        m_directory(std::move(directory)),
+        m_path(std::move(path))
+    {
+        ++m_directory->files;
+    }
+
+    ~File() override
+    {
+        // File may be missing, if build has failed
+        unlink(m_path.c_str());
+
+        --m_directory->files;
+    }
+
+    std::filesystem::path path() const override
+    {
+        return m_path;
+    }
+
+private:
+    std::shared_ptr<Directory> m_directory;
+    std::filesystem::path m_path;
+};
+
+CodeExecutor::Workspace::Workspace() :
+    Workspace(defaultRoot())
+{
+
+}
+
+CodeExecutor::Workspace::Workspace(const std::filesystem::path& root) :
+    m_directory(),
+    m_counter(0)
+{
+    auto pattern = (root / "codeexecutor-XXXXXX").string();
+
+    std::vector<char> name(pattern.begin(), pattern.end());
+    name.push_back('\0');
+
+    // Name is random and directory is created
+    // atomically, so other processes can't get it
+    if (mkdtemp(name.data()) == nullptr)
+    {
+        throw std::runtime_error("Can't create workspace in " + root.string());
+    }
+
+    m_directory = std::make_shared<Directory>(name.data());
+}
+
+CodeExecutor::ArtifactPtr CodeExecutor::Workspace::create(const std::string& name)
+{
+    // Names are hints, so counter makes them unique
+    auto fileName = std::to_string(++m_counter) + "_" + name;
+
+    return std::make_shared<File>(m_directory, m_directory->path / fileName);
+}
+
+std::filesystem::path CodeExecutor::Workspace::path() const
+{
+    return m_directory->path;
+}
+
+std::size_t CodeExecutor::Workspace::size() const
+{
+    return m_directory->files;
+}
+
+std::filesystem::path CodeExecutor::Workspace::defaultRoot()
+{
+    std::filesystem::path memory("/dev/shm");
+
+    if (access(memory.c_str(), W_OK | X_OK) == 0)
+    {
+        return memory;
+    }
+
+    return std::filesystem::temp_directory_path();
+}
@@ -1,8 +1,17 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <thread>
 #include <CodeExecutor/Source.hpp>
 #include <CodeExecutor/Builder.hpp>
 #include <CodeExecutor/CommonCompiler.hpp>
 #include <CodeExecutor/CommonLinker.hpp>
+#include <CodeExecutor/UnityBatcher.hpp>
+#include <CodeExecutor/FunctionSlot.hpp>
+#include <CodeExecutor/MemoryStorage.hpp>
+#include <CodeExecutor/SymbolRegistry.hpp>
+#include <CodeExecutor/Workspace.hpp>
 
 static CodeExecutor::BuilderPtr makeBuilder(
     std::string compiler,
@@ -31,6 +40,22 @@ static CodeExecutor::BuilderPtr makeBuilder()
     return makeBuilder("/usr/bin/gcc", "/usr/bin/gcc");
 }
 
+TEST(Building, SharedSource)
+{
+    auto buffer = std::make_shared<const std::string>("extern \"C\" int f() { return 1; }");
+
+    auto first = CodeExecutor::Source::createFromBuffer(buffer);
+    auto second = CodeExecutor::Source::createFromBuffer(buffer);
+
+    // Content is not copied
+    ASSERT_EQ(first->content().data(), buffer->data());
+    ASSERT_EQ(second->contentView().data(), buffer->data());
+    ASSERT_EQ(first->buffer(), second->buffer());
+    ASSERT_EQ(first->size(), buffer->size());
+
+    ASSERT_EQ(CodeExecutor::Source::createFromBuffer(nullptr)->size(), 0);
+}
+
 TEST(Building, SingleFunction)
 {
     const char* source =
@@ -208,3 +233,800 @@ TEST(Building, Class)
     ASSERT_EQ(target->someFunction(12), 12 * 3);
 }
 
+
+TEST(Building, ParallelTargets)
+{
+    // Creating builder
+    auto builder = makeBuilder();
+
+    builder->setJobs(4);
+
+    ASSERT_EQ(builder->jobs(), 4);
+
+    // Adding targets to be built
+    for (int i = 0; i < 8; ++i)
+    {
+        builder->addTarget(
+            CodeExecutor::Source::createFromSource(
+                "extern \"C\" int function" + std::to_string(i) + "(int number)"
+                "{ return number + " + std::to_string(i) + "; }"
+            )
+        );
+    }
+
+    CodeExecutor::LibraryPtr library;
+
+    // Building library
+    ASSERT_NO_THROW(
+        library = builder->build()
+    );
+
+    ASSERT_NE(library, nullptr);
+
+    // Checking every target was linked
+    for (int i = 0; i < 8; ++i)
+    {
+        auto function = library->resolveFunction<int(int)>(
+            ("function" + std::to_string(i)).c_str()
+        );
+
+        ASSERT_NE(function, nullptr);
+
+        ASSERT_EQ(function(12), 12 + i);
+    }
+}
+
+TEST(Building, ParallelTargetsFailure)
+{
+    // Creating builder
+    auto builder = makeBuilder();
+
+    builder->setJobs(4);
+
+    builder->addTarget(
+        CodeExecutor::Source::createFromSource(
+            "extern \"C\" int function(int number)"
+            "{ return number; }"
+        )
+    );
+
+    // Source with error
+    builder->addTarget(
+        CodeExecutor::Source::createFromSource(
+            "extern \"C\" int broken(int number)"
+            "{ return number }"
+        )
+    );
+
+    ASSERT_THROW(
+        builder->build(),
+        std::runtime_error
+    );
+}
+
+TEST(Building, Incremental)
+{
+    // Creating builder
+    auto builder = makeBuilder();
+
+    builder->setIncremental(true);
+
+    auto first = CodeExecutor::Source::createFromSource(
+        "extern \"C\" int first(int number)"
+        "{ return number + 1; }"
+    );
+
+    auto second = CodeExecutor::Source::createFromSource(
+        "extern \"C\" int second(int number)"
+        "{ return number + 2; }"
+    );
+
+    builder->addTarget(first, "incremental_first.o");
+    builder->addTarget(second, "incremental_second.o");
+
+    // First build compiles everything
+    ASSERT_NO_THROW(
+        builder->build()
+    );
+
+    ASSERT_EQ(builder->rebuiltTargets().size(), 2);
+
+    // Changing second target
+    builder->removeTarget(second);
+
+    builder->addTarget(
+        CodeExecutor::Source::createFromSource(
+            "extern \"C\" int second(int number)"
+            "{ return number + 3; }"
+        ),
+        "incremental_second.o"
+    );
+
+    CodeExecutor::LibraryPtr library;
+
+    ASSERT_NO_THROW(
+        library = builder->build()
+    );
+
+    // Only changed target was compiled
+    auto rebuilt = builder->rebuiltTargets();
+
+    ASSERT_EQ(rebuilt.size(), 1);
+    ASSERT_EQ(rebuilt.front(), "incremental_second.o");
+
+    auto function1 = library->resolveFunction<int(int)>("first");
+    auto function2 = library->resolveFunction<int(int)>("second");
+
+    ASSERT_NE(function1, nullptr);
+    ASSERT_NE(function2, nullptr);
+
+    ASSERT_EQ(function1(12), 13);
+    ASSERT_EQ(function2(12), 15);
+
+    // Nothing changed
+    ASSERT_NO_THROW(
+        builder->build()
+    );
+
+    ASSERT_TRUE(builder->rebuiltTargets().empty());
+}
+
+TEST(Building, Async)
+{
+    // Creating builder
+    auto builder = makeBuilder();
+
+    builder->setExecutor(std::make_shared<CodeExecutor::Executor>(2));
+
+    builder->addTarget(
+        CodeExecutor::Source::createFromSource(
+            "extern \"C\" int function(int number)"
+            "{ return number - 1; }"
+        )
+    );
+
+    auto future = builder->buildAsync();
+
+    CodeExecutor::LibraryPtr library;
+
+    ASSERT_NO_THROW(
+        library = future.get()
+    );
+
+    ASSERT_NE(library, nullptr);
+
+    auto function = library->resolveFunction<int(int)>("function");
+
+    ASSERT_NE(function, nullptr);
+
+    ASSERT_EQ(function(12), 11);
+
+    // Errors are passed to callback
+    builder->addTarget(
+        CodeExecutor::Source::createFromSource("broken")
+    );
+
+    std::promise<std::exception_ptr> error;
+
+    builder->buildAsync(
+        [&error](CodeExecutor::LibraryPtr, std::exception_ptr exception)
+        {
+            error.set_value(exception);
+        }
+    );
+
+    ASSERT_NE(error.get_future().get(), nullptr);
+}
+
+TEST(Building, UnityNames)
+{
+    auto names = CodeExecutor::UnityBatcher::declaredNames(
+        "#include <vector>\n"
+        "#define LIMIT 10\n"
+        "namespace {\n"
+        "    int counter = 0;\n"
+        "    int helper(int a, int b) { int local = a; return local + b; }\n"
+        "}\n"
+        "static const char* name = \"value;\";\n"
+        "class Object { public: int member; };\n"
+        "extern \"C\" int function(int number) { return helper(number, LIMIT); }\n"
+    );
+
+    ASSERT_EQ(
+        names,
+        CodeExecutor::UnityBatcher::NamesContainer({
+            "counter", "helper", "name", "Object", "function"
+        })
+    );
+}
+
+TEST(Building, Unity)
+{
+    // Creating builder
+    auto builder = makeBuilder();
+
+    builder->setUnityBuild(true);
+    builder->setUnityBatchSize(3);
+
+    // Every target has helper with the same name
+    // and equal sources are split, other are merged
+    for (int i = 0; i < 4; ++i)
+    {
+        builder->addTarget(
+            CodeExecutor::Source::createFromSource(
+                "namespace { int helper(int number) { return number + " + std::to_string(i) + "; } }\n"
+                "extern \"C\" int function" + std::to_string(i) + "(int number)"
+                "{ return helper(number); }"
+            )
+        );
+
+        builder->addTarget(
+            CodeExecutor::Source::createFromSource(
+                "extern \"C\" int other" + std::to_string(i) + "(int number)"
+                "{ return number * " + std::to_string(i) + "; }"
+            )
+        );
+    }
+
+    CodeExecutor::LibraryPtr library;
+
+    // Building library
+    ASSERT_NO_THROW(
+        library = builder->build()
+    );
+
+    ASSERT_NE(library, nullptr);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        auto function = library->resolveFunction<int(int)>(
+            ("function" + std::to_string(i)).c_str()
+        );
+
+        auto other = library->resolveFunction<int(int)>(
+            ("other" + std::to_string(i)).c_str()
+        );
+
+        ASSERT_NE(function, nullptr);
+        ASSERT_NE(other, nullptr);
+
+        ASSERT_EQ(function(12), 12 + i);
+        ASSERT_EQ(other(12), 12 * i);
+    }
+}
+
+TEST(Building, PrecompiledHeader)
+{
+    // Creating builder
+    auto builder = makeBuilder();
+
+    auto context = std::make_shared<CodeExecutor::BuildingContext>();
+
+    context->setAutomaticPrecompiledHeader(true);
+
+    builder->setBuildingContext(context);
+
+    for (int i = 0; i < 2; ++i)
+    {
+        builder->addTarget(
+            CodeExecutor::Source::createFromSource(
+                "#include <vector>\n"
+                "#include <numeric>\n"
+                "extern \"C\" int function" + std::to_string(i) + "(int number)"
+                "{ std::vector<int> v(number, " + std::to_string(i) + ");"
+                "  return std::accumulate(v.begin(), v.end(), 0); }"
+            )
+        );
+    }
+
+    CodeExecutor::LibraryPtr library;
+
+    // Building library
+    ASSERT_NO_THROW(
+        library = builder->build()
+    );
+
+    auto function = library->resolveFunction<int(int)>("function1");
+
+    ASSERT_NE(function, nullptr);
+
+    ASSERT_EQ(function(12), 12);
+
+    // Explicit header
+    context->setPrecompiledHeader("#define HEADER_VALUE 7\n");
+
+    builder->clearTargets();
+
+    builder->addTarget(
+        CodeExecutor::Source::createFromSource(
+            "extern \"C\" int function(int number)"
+            "{ return number + HEADER_VALUE; }"
+        )
+    );
+
+    ASSERT_NO_THROW(
+        library = builder->build()
+    );
+
+    auto header = library->resolveFunction<int(int)>("function");
+
+    ASSERT_NE(header, nullptr);
+
+    ASSERT_EQ(header(12), 19);
+}
+
+TEST(Building, Tiered)
+{
+    // Creating builder
+    auto builder = makeBuilder();
+
+    builder->addTarget(
+        CodeExecutor::Source::createFromSource(
+            "extern \"C\" int function(int number)"
+            "{ return number * 4; }\n"
+            "extern \"C\" int optimized()"
+            "{\n"
+            "#ifdef __OPTIMIZE__\n"
+            "    return 1;\n"
+            "#else\n"
+            "    return 0;\n"
+            "#endif\n"
+            "}"
+        )
+    );
+
+    CodeExecutor::TieredLibraryPtr library;
+
+    ASSERT_NO_THROW(
+        library = builder->buildTiered()
+    );
+
+    ASSERT_NE(library, nullptr);
+
+    auto function = library->resolveFunction<int(int)>("function");
+    auto optimized = library->resolveFunction<int()>("optimized");
+
+    ASSERT_NE(function, nullptr);
+    ASSERT_NE(optimized, nullptr);
+
+    ASSERT_EQ(function(12), 48);
+
+    // Resolved functions are switched to optimized build
+    ASSERT_TRUE(library->waitOptimized());
+
+    ASSERT_EQ(function(12), 48);
+    ASSERT_EQ(optimized(), 1);
+
+    ASSERT_EQ(library->resolveFunction<int()>("missing"), nullptr);
+}
+
+TEST(Building, TieredPromotionFailure)
+{
+    auto builder = makeBuilder();
+
+    builder->addTarget(
+        CodeExecutor::Source::createFromSource(
+            "extern \"C\" int function(int value) { return value + 1; }"
+        ),
+        "tiered_failure.o"
+    );
+
+    auto library = std::make_shared<CodeExecutor::TieredLibrary>(builder->build());
+
+    auto function = library->resolveFunction<int(int)>("function");
+
+    ASSERT_NE(function, nullptr);
+
+    // Linker returns unloaded library instead of throwing
+    library->promote(std::make_shared<CodeExecutor::Library>("/nonexistent/library.so"));
+
+    ASSERT_FALSE(library->waitOptimized());
+    ASSERT_FALSE(library->isOptimized());
+    ASSERT_NE(library->optimizationError(), nullptr);
+
+    ASSERT_EQ(function(1), 2);
+}
+
+TEST(Building, InMemory)
+{
+    auto storage = std::make_shared<CodeExecutor::MemoryStorage>();
+
+    auto linker = std::make_shared<CodeExecutor::CommonLinker>("/usr/bin/gcc");
+
+    linker->setStorage(storage);
+
+    CodeExecutor::Builder builder;
+
+    builder.setCompiler(std::make_shared<CodeExecutor::CommonCompiler>("/usr/bin/gcc"));
+    builder.setLinker(linker);
+    builder.setStorage(storage);
+    builder.setJobs(2);
+
+    builder.addTarget(
+        CodeExecutor::Source::createFromSource(
+            "extern \"C\" int add(int a, int b) { return a + b; }"
+        ),
+        "memory_add.o"
+    );
+
+    builder.addTarget(
+        CodeExecutor::Source::createFromSource(
+            "extern \"C\" int add(int, int);"
+            "extern \"C\" int twice(int a) { return add(a, a); }"
+        ),
+        "memory_twice.o"
+    );
+
+    CodeExecutor::LibraryPtr library;
+
+    ASSERT_NO_THROW(library = builder.build());
+
+    ASSERT_TRUE(library->isLoaded()) << library->errorString();
+    ASSERT_EQ(library->path().string().compare(0, 6, "/proc/"), 0);
+
+    auto function = library->resolveFunction<int(int)>("twice");
+
+    ASSERT_NE(function, nullptr);
+    ASSERT_EQ(function(21), 42);
+
+    ASSERT_FALSE(std::filesystem::exists("memory_add.o"));
+    ASSERT_FALSE(std::filesystem::exists("memory_twice.o"));
+}
+
+TEST(Building, Workspace)
+{
+    auto workspace = std::make_shared<CodeExecutor::Workspace>();
+    auto directory = workspace->path();
+
+    auto linker = std::make_shared<CodeExecutor::CommonLinker>("/usr/bin/gcc");
+
+    {
+        CodeExecutor::Builder builder;
+
+        // Storage of builder is passed to linker
+        builder.setCompiler(std::make_shared<CodeExecutor::CommonCompiler>("/usr/bin/gcc"));
+        builder.setLinker(linker);
+        builder.setStorage(workspace);
+        builder.setJobs(1);
+
+        builder.addTarget(
+            CodeExecutor::Source::createFromSource(
+                "extern \"C\" int triple(int a) { return a * 3; }"
+            )
+        );
+
+        auto first = builder.build();
+        auto second = builder.build();
+
+        ASSERT_TRUE(first->isLoaded()) << first->errorString();
+        ASSERT_TRUE(second->isLoaded()) << second->errorString();
+        ASSERT_NE(first->path(), second->path());
+        ASSERT_EQ(first->path().parent_path(), directory);
+
+        ASSERT_EQ(first->resolveFunction<int(int)>("triple")(5), 15);
+
+        auto path = first->path();
+
+        first.reset();
+
+        ASSERT_FALSE(std::filesystem::exists(path));
+        ASSERT_TRUE(std::filesystem::exists(second->path()));
+    }
+
+    // Everything is released with builder
+    ASSERT_EQ(workspace->size(), 0);
+    ASSERT_TRUE(std::filesystem::is_empty(directory));
+
+    workspace.reset();
+    linker.reset();
+
+    ASSERT_FALSE(std::filesystem::exists(directory));
+}
+
+TEST(Building, DefaultWorkspace)
+{
+    std::filesystem::path path;
+
+    {
+        CodeExecutor::Builder builder;
+
+        builder.setCompiler(std::make_shared<CodeExecutor::CommonCompiler>("/usr/bin/gcc"));
+        builder.setLinker(std::make_shared<CodeExecutor::CommonLinker>("/usr/bin/gcc"));
+
+        builder.addTarget(
+            CodeExecutor::Source::createFromSource(
+                "extern \"C\" int twice(int a) { return a * 2; }"
+            ),
+            "default_workspace.o"
+        );
+
+        auto library = builder.build();
+
+        ASSERT_TRUE(library->isLoaded()) << library->errorString();
+        ASSERT_EQ(library->resolveFunction<int(int)>("twice")(4), 8);
+
+        path = library->path();
+    }
+
+    // Nothing is left in current directory
+    ASSERT_NE(path.parent_path(), std::filesystem::current_path());
+    ASSERT_FALSE(std::filesystem::exists(path));
+    ASSERT_FALSE(std::filesystem::exists("default_workspace.o"));
+}
+
+TEST(Building, Symbols)
+{
+    auto builder = makeBuilder();
+
+    builder->addTarget(
+        CodeExecutor::Source::createFromSource(
+            "extern \"C\" int first(int a) { return a + 1; }"
+            "extern \"C\" int second(int a) { return a + 2; }"
+            "extern \"C\" { int counter = 7; }"
+            "static int hidden() { return 0; }"
+        ),
+        "symbols.o"
+    );
+
+    auto library = builder->build();
+
+    ASSERT_TRUE(library->isLoaded()) << library->errorString();
+
+    auto symbols = library->symbols();
+
+    for (auto name : {"first", "second", "counter"})
+    {
+        ASSERT_NE(std::find(symbols.begin(), symbols.end(), name), symbols.end()) << name;
+    }
+
+    ASSERT_EQ(std::find(symbols.begin(), symbols.end(), "hidden"), symbols.end());
+
+    auto addresses = library->resolveAll({"first", "missing", "second"});
+
+    ASSERT_EQ(addresses.size(), 3);
+    ASSERT_EQ(addresses[0], library->resolve("first"));
+    ASSERT_EQ(addresses[1], nullptr);
+    ASSERT_EQ(addresses[2], library->resolve("second"));
+
+    auto registry = std::make_shared<CodeExecutor::SymbolRegistry>();
+
+    ASSERT_GE(registry->add(library), 3);
+    ASSERT_EQ(registry->add(library), 0);
+
+    auto symbol = registry->find("second");
+
+    ASSERT_EQ(symbol.library, library);
+    ASSERT_EQ(reinterpret_cast<int(*)(int)>(symbol.address)(40), 42);
+    ASSERT_EQ(*static_cast<int*>(registry->find("counter").address), 7);
+    ASSERT_EQ(registry->find("missing").library, nullptr);
+
+    symbol = {};
+    library.reset();
+    builder.reset();
+
+    ASSERT_EQ(registry->find("first").library, nullptr);
+    ASSERT_EQ(registry->size(), 0);
+}
+
+TEST(Building, SymbolShadowing)
+{
+    auto build = [](const std::string& source, const std::string& name)
+    {
+        auto builder = makeBuilder();
+
+        builder->addTarget(CodeExecutor::Source::createFromSource(source), name);
+
+        return builder->build();
+    };
+
+    auto first = build("extern \"C\" int shadowed() { return 1; }", "shadowed_first.o");
+    auto second = build("extern \"C\" int shadowed() { return 2; }", "shadowed_second.o");
+
+    ASSERT_TRUE(first->isLoaded()) << first->errorString();
+    ASSERT_TRUE(second->isLoaded()) << second->errorString();
+
+    auto registry = std::make_shared<CodeExecutor::SymbolRegistry>();
+
+    // Library is registered once, even if
+    // it's added from several threads
+    std::vector<std::thread> threads;
+    std::atomic<std::size_t> added(0);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            added += registry->add(first);
+        });
+    }
+
+    for (auto&& thread : threads)
+    {
+        thread.join();
+    }
+
+    ASSERT_EQ(added, first->symbols().size());
+    ASSERT_GT(registry->add(second), 0);
+
+    ASSERT_EQ(registry->find("shadowed").library, second);
+
+    // Previous owner is visible again
+    ASSERT_TRUE(second->unload());
+
+    auto symbol = registry->find("shadowed");
+
+    ASSERT_EQ(symbol.library, first);
+    ASSERT_EQ(reinterpret_cast<int(*)()>(symbol.address)(), 1);
+
+    symbol = {};
+    first.reset();
+
+    ASSERT_EQ(registry->find("shadowed").library, nullptr);
+    ASSERT_EQ(registry->size(), 0);
+}
+
+TEST(Building, FunctionHandle)
+{
+    auto builder = makeBuilder();
+
+    builder->addTarget(
+        CodeExecutor::Source::createFromSource(
+            "extern \"C\" int negate(int a) { return -a; }"
+        ),
+        "handle.o"
+    );
+
+    auto library = builder->build();
+
+    ASSERT_TRUE(library->isLoaded()) << library->errorString();
+
+    auto function = library->resolveFunction<int(int)>("negate");
+
+    ASSERT_TRUE(function);
+    ASSERT_EQ(function.library(), library);
+    ASSERT_EQ(function.pointer(), library->resolve("negate"));
+
+    ASSERT_FALSE(library->resolveFunction<int(int)>("missing"));
+    ASSERT_FALSE(CodeExecutor::Function<int(int)>());
+
+    // Function keeps library loaded
+    std::weak_ptr<CodeExecutor::Library> weak = library;
+
+    library.reset();
+    builder.reset();
+
+    ASSERT_FALSE(weak.expired());
+    ASSERT_EQ(function(5), -5);
+
+    function = {};
+
+    ASSERT_TRUE(weak.expired());
+}
+
+TEST(Building, LoadUnload)
+{
+    auto builder = makeBuilder();
+
+    builder->addTarget(
+        CodeExecutor::Source::createFromSource(
+            "extern \"C\" int square(int a) { return a * a; }"
+        ),
+        "reload.o"
+    );
+
+    auto library = builder->build();
+
+    ASSERT_TRUE(library->isLoaded()) << library->errorString();
+    ASSERT_NE(library->resolve("square"), nullptr);
+
+    ASSERT_TRUE(library->unload());
+    ASSERT_FALSE(library->isLoaded());
+    ASSERT_FALSE(library->unload());
+    ASSERT_EQ(library->resolve("square"), nullptr);
+
+    ASSERT_TRUE(library->load()) << library->errorString();
+    ASSERT_TRUE(library->load());
+    ASSERT_EQ(library->resolveFunction<int(int)>("square")(9), 81);
+}
+
+static CodeExecutor::LibraryPtr buildVersion(int version)
+{
+    auto builder = makeBuilder();
+
+    builder->addTarget(
+        CodeExecutor::Source::createFromSource(
+            "extern \"C\" int version() { return " + std::to_string(version) + "; }"
+        ),
+        "version_" + std::to_string(version) + ".o"
+    );
+
+    return builder->build();
+}
+
+TEST(Building, FunctionSlot)
+{
+    CodeExecutor::FunctionSlot<int()> slot("version");
+
+    ASSERT_FALSE(slot);
+    ASSERT_FALSE(slot.publish(nullptr));
+
+    auto first = buildVersion(1);
+    auto second = buildVersion(2);
+
+    ASSERT_TRUE(slot.publish(first));
+    ASSERT_EQ(slot(), 1);
+
+    std::weak_ptr<CodeExecutor::Library> weak = first;
+    first.reset();
+
+    // Reader is inside of critical section, that
+    // started before swap, so first library stays
+    std::promise<void> entered;
+    std::promise<void> leave;
+
+    std::thread reader([&]()
+    {
+        CodeExecutor::Epoch::Guard guard;
+
+        entered.set_value();
+        leave.get_future().wait();
+    });
+
+    entered.get_future().wait();
+
+    ASSERT_TRUE(slot.publish(second));
+    ASSERT_EQ(slot(), 2);
+    ASSERT_EQ(slot.library(), second);
+
+    CodeExecutor::Epoch::reclaim();
+
+    ASSERT_FALSE(weak.expired());
+
+    leave.set_value();
+    reader.join();
+
+    CodeExecutor::Epoch::synchronize();
+
+    ASSERT_TRUE(weak.expired());
+
+    // Calls never see unloaded code
+    std::atomic_bool stop(false);
+    std::atomic_int wrong(0);
+
+    std::vector<std::thread> callers;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        callers.emplace_back([&]()
+        {
+            while (!stop)
+            {
+                auto value = slot();
+
+                if (value < 2 || value > 6)
+                {
+                    ++wrong;
+                }
+            }
+        });
+    }
+
+    for (int version = 3; version <= 6; ++version)
+    {
+        ASSERT_TRUE(slot.publish(buildVersion(version)));
+    }
+
+    stop = true;
+
+    for (auto&& caller : callers)
+    {
+        caller.join();
+    }
+
+    ASSERT_EQ(wrong, 0);
+    ASSERT_EQ(slot(), 6);
+
+    CodeExecutor::Epoch::synchronize();
+
+    ASSERT_EQ(CodeExecutor::Epoch::retired(), 0);
+}
@@ -0,0 +1,270 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <unistd.h>
+#include <CodeExecutor/Sha256.hpp>
+#include <CodeExecutor/Source.hpp>
+#include <CodeExecutor/Builder.hpp>
+#include <CodeExecutor/CachingCompiler.hpp>
+#include <CodeExecutor/CommonCompiler.hpp>
+#include <CodeExecutor/CommonLinker.hpp>
+
+static std::filesystem::path makeCacheDirectory(const std::string& name)
+{
+    auto path = std::filesystem::temp_directory_path() /
+                ("CodeExecutorTests_" + name + "_" + std::to_string(getpid()));
+
+    std::filesystem::remove_all(path);
+
+    return path;
+}
+
+static CodeExecutor::BuilderPtr makeBuilder(CodeExecutor::CompilerPtr compiler)
+{
+    auto builder = std::make_shared<CodeExecutor::Builder>();
+
+    builder->setCompiler(std::move(compiler));
+
+    builder->setLinker(
+        std::make_shared<CodeExecutor::CommonLinker>(
+            "/usr/bin/gcc"
+        )
+    );
+
+    return builder;
+}
+
+TEST(Caching, Sha256)
+{
+    ASSERT_EQ(
+        CodeExecutor::Sha256::hash(""),
+        "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"
+    );
+
+    ASSERT_EQ(
+        CodeExecutor::Sha256::hash("abc"),
+        "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"
+    );
+
+    // Message, that crosses block border
+    ASSERT_EQ(
+        CodeExecutor::Sha256::hash(std::string(1000, 'a')),
+        "41edece42d63e8d9bf515a9ba6932e1c20cbc9f5a5d134645adb5db1b9737ea3"
+    );
+
+    // Many blocks, processed by one call
+    ASSERT_EQ(
+        CodeExecutor::Sha256::hash(std::string(1000000, 'a')),
+        "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"
+    );
+
+    auto source = CodeExecutor::Source::createFromSource("abc");
+
+    ASSERT_EQ(source->fingerprint(), CodeExecutor::Sha256::hash("abc"));
+    ASSERT_EQ(&source->fingerprint(), &source->fingerprint());
+}
+
+TEST(Caching, HitAndMiss)
+{
+    auto directory = makeCacheDirectory("HitAndMiss");
+
+    auto compiler = std::make_shared<CodeExecutor::CachingCompiler>(
+        std::make_shared<CodeExecutor::CommonCompiler>("/usr/bin/gcc"),
+        directory,
+        1024 * 1024
+    );
+
+    auto builder = makeBuilder(compiler);
+
+    builder->addTarget(
+        CodeExecutor::Source::createFromSource(
+            "extern \"C\" int function(int number)"
+            "{ return number * 2; }"
+        )
+    );
+
+    CodeExecutor::LibraryPtr library;
+
+    // First build compiles source
+    ASSERT_NO_THROW(
+        library = builder->build()
+    );
+
+    ASSERT_EQ(compiler->hits(), 0);
+    ASSERT_EQ(compiler->misses(), 1);
+
+    // Second build takes object from cache
+    ASSERT_NO_THROW(
+        library = builder->build()
+    );
+
+    ASSERT_EQ(compiler->hits(), 1);
+    ASSERT_EQ(compiler->misses(), 1);
+
+    auto function = library->resolveFunction<int(int)>("function");
+
+    ASSERT_NE(function, nullptr);
+
+    ASSERT_EQ(function(12), 24);
+
+    // Cache is persistent
+    auto reloaded = std::make_shared<CodeExecutor::CachingCompiler>(
+        std::make_shared<CodeExecutor::CommonCompiler>("/usr/bin/gcc"),
+        directory,
+        1024 * 1024
+    );
+
+    ASSERT_EQ(reloaded->size(), compiler->size());
+
+    builder->setCompiler(reloaded);
+
+    ASSERT_NO_THROW(
+        builder->build()
+    );
+
+    ASSERT_EQ(reloaded->hits(), 1);
+    ASSERT_EQ(reloaded->misses(), 0);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(Caching, Eviction)
+{
+    auto directory = makeCacheDirectory("Eviction");
+
+    // Budget is enough for one small object only
+    auto compiler = std::make_shared<CodeExecutor::CachingCompiler>(
+        std::make_shared<CodeExecutor::CommonCompiler>("/usr/bin/gcc"),
+        directory,
+        3 * 1024
+    );
+
+    auto builder = makeBuilder(compiler);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        builder->clearTargets();
+
+        builder->addTarget(
+            CodeExecutor::Source::createFromSource(
+                "extern \"C\" int function(int number)"
+                "{ return number + " + std::to_string(i) + "; }"
+            )
+        );
+
+        ASSERT_NO_THROW(
+            builder->build()
+        );
+    }
+
+    ASSERT_EQ(compiler->misses(), 3);
+    ASSERT_LE(compiler->size(), compiler->sizeBudget());
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(Caching, LibraryCacheSingleFlight)
+{
+    auto cache = std::make_shared<CodeExecutor::LibraryCache>();
+
+    auto compiler = std::make_shared<CodeExecutor::CommonCompiler>("/usr/bin/gcc");
+    auto linker = std::make_shared<CodeExecutor::CommonLinker>("/usr/bin/gcc");
+
+    // Builders with identical targets
+    std::vector<CodeExecutor::BuilderPtr> builders;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        auto builder = std::make_shared<CodeExecutor::Builder>();
+
+        builder->setCompiler(compiler);
+        builder->setLinker(linker);
+        builder->setLibraryCache(cache);
+
+        builder->addTarget(
+            CodeExecutor::Source::createFromSource(
+                "extern \"C\" int function(int number)"
+                "{ return number * 3; }"
+            )
+        );
+
+        builders.push_back(builder);
+    }
+
+    ASSERT_EQ(builders[0]->fingerprint(), builders[1]->fingerprint());
+
+    std::vector<CodeExecutor::LibraryPtr> libraries(builders.size());
+    std::vector<std::thread> threads;
+
+    for (std::size_t i = 0; i < builders.size(); ++i)
+    {
+        threads.emplace_back(
+            [&, i]()
+            {
+                libraries[i] = builders[i]->build();
+            }
+        );
+    }
+
+    for (auto&& thread : threads)
+    {
+        thread.join();
+    }
+
+    // Only one build was performed
+    ASSERT_EQ(cache->misses(), 1);
+    ASSERT_EQ(cache->hits(), builders.size() - 1);
+
+    for (auto&& library : libraries)
+    {
+        ASSERT_EQ(library, libraries.front());
+    }
+
+    auto function = libraries.front()->resolveFunction<int(int)>("function");
+
+    ASSERT_NE(function, nullptr);
+
+    ASSERT_EQ(function(12), 36);
+}
+
+TEST(Caching, LibraryCacheFailure)
+{
+    CodeExecutor::LibraryCache cache;
+
+    ASSERT_THROW(
+        cache.get(
+            "key",
+            []() -> CodeExecutor::LibraryPtr
+            {
+                throw std::runtime_error("Build failed");
+            }
+        ),
+        std::runtime_error
+    );
+
+    // Failed build is not stored
+    ASSERT_FALSE(cache.contains("key"));
+}
+
+TEST(Caching, LibraryCacheEviction)
+{
+    CodeExecutor::LibraryCache cache(2);
+
+    auto factory = []()
+    {
+        return CodeExecutor::LibraryPtr();
+    };
+
+    cache.get("first", factory);
+    cache.get("second", factory);
+
+    // First library becomes most recently used
+    cache.get("first", factory);
+    cache.get("third", factory);
+
+    ASSERT_EQ(cache.size(), 2);
+    ASSERT_TRUE(cache.contains("first"));
+    ASSERT_FALSE(cache.contains("second"));
+    ASSERT_TRUE(cache.contains("third"));
+    ASSERT_EQ(cache.hits(), 1);
+    ASSERT_EQ(cache.misses(), 3);
+}
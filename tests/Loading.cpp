@@ -0,0 +1,352 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <fstream>
+#include <CodeExecutor/Builder.hpp>
+#include <CodeExecutor/CommonCompiler.hpp>
+#include <CodeExecutor/CommonLinker.hpp>
+#include <CodeExecutor/ElfLoader.hpp>
+#include <CodeExecutor/MemoryStorage.hpp>
+#include <CodeExecutor/Process.hpp>
+
+#ifdef CODEEXECUTOR_WITH_LLVM
+#include <CodeExecutor/OrcLinker.hpp>
+#endif
+
+static CodeExecutor::LibraryPtr loadSource(const CodeExecutor::ElfLoaderPtr& loader,
+                                           const std::string& source)
+{
+    auto storage = std::make_shared<CodeExecutor::MemoryStorage>();
+    auto linker = std::make_shared<CodeExecutor::CommonLinker>("/usr/bin/gcc");
+
+    linker->setStorage(storage);
+    linker->setLoader(loader);
+
+    CodeExecutor::Builder builder;
+
+    builder.setCompiler(std::make_shared<CodeExecutor::CommonCompiler>("/usr/bin/gcc"));
+    builder.setLinker(linker);
+    builder.setStorage(storage);
+
+    builder.addTarget(CodeExecutor::Source::createFromSource(source));
+
+    return builder.build();
+}
+
+static int hostValue()
+{
+    return 17;
+}
+
+TEST(Loading, Functions)
+{
+    auto loader = std::make_shared<CodeExecutor::ElfLoader>();
+
+    loader->addImport("host_value", reinterpret_cast<void*>(&hostValue));
+
+    auto library = loadSource(
+        loader,
+        "#include <cstring>\n"
+        "#include <string>\n"
+        "#include <vector>\n"
+        "#include <stdexcept>\n"
+        "extern \"C\" int host_value();\n"
+        "static int initialized = 0;\n"
+        "static struct Init { Init() { initialized = 42; } } init;\n"
+        "extern \"C\" { int counter = 5; }\n"
+        "extern \"C\" int add(int a, int b) { return a + b; }\n"
+        "extern \"C\" int constructed() { return initialized; }\n"
+        "extern \"C\" int increment() { return ++counter; }\n"
+        "extern \"C\" int length(const char* text) { return std::strlen(text); }\n"
+        "extern \"C\" int host() { return host_value() * 2; }\n"
+        "extern \"C\" int join(int count) {\n"
+        "    std::vector<std::string> parts(count, \"ab\");\n"
+        "    std::string result;\n"
+        "    for (auto&& part : parts) result += part;\n"
+        "    return result.size();\n"
+        "}\n"
+        "extern \"C\" int guarded(int value) {\n"
+        "    try { if (value < 0) throw std::runtime_error(\"negative\"); }\n"
+        "    catch (const std::exception&) { return -1; }\n"
+        "    return value;\n"
+        "}\n"
+    );
+
+    ASSERT_TRUE(library->isLoaded()) << library->errorString();
+
+    ASSERT_EQ(library->resolveFunction<int(int, int)>("add")(2, 3), 5);
+    ASSERT_EQ(library->resolveFunction<int()>("constructed")(), 42);
+    ASSERT_EQ(library->resolveFunction<int()>("increment")(), 6);
+    ASSERT_EQ(*static_cast<int*>(library->resolve("counter")), 6);
+    ASSERT_EQ(library->resolveFunction<int(const char*)>("length")("hello"), 5);
+    ASSERT_EQ(library->resolveFunction<int()>("host")(), 34);
+    ASSERT_EQ(library->resolveFunction<int(int)>("join")(10), 20);
+    ASSERT_EQ(library->resolveFunction<int(int)>("guarded")(-5), -1);
+    ASSERT_EQ(library->resolveFunction<int(int)>("guarded")(5), 5);
+
+    ASSERT_EQ(library->resolve("missing"), nullptr);
+    ASSERT_NE(library->errorString().find("missing"), std::string::npos);
+
+    auto symbols = library->symbols();
+
+    ASSERT_NE(std::find(symbols.begin(), symbols.end(), "add"), symbols.end());
+    ASSERT_NE(std::find(symbols.begin(), symbols.end(), "counter"), symbols.end());
+
+    // Code isn't registered in dynamic linker
+    Dl_info info;
+    ASSERT_EQ(dladdr(library->resolve("add"), &info), 0);
+}
+
+TEST(Loading, Reload)
+{
+    auto loader = std::make_shared<CodeExecutor::ElfLoader>();
+    auto arena = loader->arena();
+
+    auto library = loadSource(
+        loader,
+        "extern \"C\" { int value = 1; }\n"
+        "extern \"C\" int next() { return ++value; }\n"
+    );
+
+    ASSERT_TRUE(library->isLoaded()) << library->errorString();
+    ASSERT_GT(arena->used(), 0);
+
+    auto used = arena->used();
+
+    ASSERT_EQ(library->resolveFunction<int()>("next")(), 2);
+
+    ASSERT_TRUE(library->unload());
+    ASSERT_EQ(arena->used(), 0);
+    ASSERT_EQ(library->resolve("next"), nullptr);
+
+    // Data is loaded from image again
+    ASSERT_TRUE(library->load()) << library->errorString();
+    ASSERT_EQ(arena->used(), used);
+    ASSERT_EQ(library->resolveFunction<int()>("next")(), 2);
+
+    library.reset();
+
+    ASSERT_EQ(arena->used(), 0);
+}
+
+TEST(Loading, Errors)
+{
+    auto loader = std::make_shared<CodeExecutor::ElfLoader>();
+
+    auto library = loadSource(
+        loader,
+        "extern \"C\" int undefined_function();\n"
+        "extern \"C\" int call() { return undefined_function(); }\n"
+    );
+
+    ASSERT_FALSE(library->isLoaded());
+    ASSERT_NE(library->errorString().find("undefined_function"), std::string::npos);
+
+    auto garbage = loader->load(std::make_shared<const std::string>("not an elf file"));
+
+    ASSERT_FALSE(garbage->isLoaded());
+    ASSERT_FALSE(garbage->errorString().empty());
+
+    ASSERT_EQ(loader->arena()->used(), 0);
+}
+
+TEST(Loading, IndirectFunctions)
+{
+    auto loader = std::make_shared<CodeExecutor::ElfLoader>();
+
+    auto library = loadSource(
+        loader,
+        "static int twice(int value) { return value * 2; }\n"
+        "extern \"C\" void* resolver() { return reinterpret_cast<void*>(&twice); }\n"
+        "extern \"C\" int kernel(int) __attribute__((ifunc(\"resolver\")));\n"
+        "__attribute__((target_clones(\"avx2\", \"default\")))\n"
+        "int cloned(int value) { return value + 1; }\n"
+        "extern \"C\" int call(int value) { return kernel(value) + cloned(value); }\n"
+    );
+
+    ASSERT_TRUE(library->isLoaded()) << library->errorString();
+
+    ASSERT_EQ(library->resolveFunction<int(int)>("kernel")(5), 10);
+    ASSERT_EQ(library->resolveFunction<int(int)>("call")(5), 16);
+}
+
+static std::string protection(const void* address)
+{
+    std::ifstream maps("/proc/self/maps");
+
+    std::string line;
+
+    while (std::getline(maps, line))
+    {
+        std::size_t begin;
+        std::size_t end;
+        char access[5] = {};
+
+        if (std::sscanf(line.c_str(), "%zx-%zx %4s", &begin, &end, access) == 3 &&
+            reinterpret_cast<std::size_t>(address) >= begin &&
+            reinterpret_cast<std::size_t>(address) < end)
+        {
+            return access;
+        }
+    }
+
+    return std::string();
+}
+
+TEST(Loading, SmallImage)
+{
+    std::ofstream("small_image.c") << "int next(int value) { return value + 1; }\n";
+
+    // Single writable and executable segment,
+    // smaller than page
+    CodeExecutor::Process process(
+        "/usr/bin/gcc",
+        {"-shared", "-fPIC", "-nostdlib", "-Wl,-N", "small_image.c", "-o", "small_image.so"}
+    );
+
+    ASSERT_EQ(process.start(), 0) << process.readStandardError();
+
+    auto loader = std::make_shared<CodeExecutor::ElfLoader>();
+
+    auto library = loader->load(std::filesystem::path("small_image.so"));
+
+    ASSERT_TRUE(library->isLoaded()) << library->errorString();
+
+    auto next = library->resolveFunction<int(int)>("next");
+
+    ASSERT_NE(next, nullptr);
+    ASSERT_EQ(protection(library->resolve("next")).substr(0, 3), "rwx");
+    ASSERT_EQ(next(1), 2);
+}
+
+#ifdef CODEEXECUTOR_WITH_LLVM
+TEST(Loading, OrcLinker)
+{
+    auto linker = std::make_shared<CodeExecutor::OrcLinker>();
+
+    CodeExecutor::Builder builder;
+
+    builder.setCompiler(std::make_shared<CodeExecutor::CommonCompiler>("/usr/bin/gcc"));
+    builder.setLinker(linker);
+    builder.setStorage(std::make_shared<CodeExecutor::MemoryStorage>());
+
+    builder.addTarget(
+        CodeExecutor::Source::createFromSource(
+            "#include <cstring>\n"
+            "extern \"C\" int length(const char* text) { return std::strlen(text); }\n"
+        )
+    );
+
+    builder.addTarget(
+        CodeExecutor::Source::createFromSource(
+            "extern \"C\" int length(const char*);\n"
+            "extern \"C\" int twice(const char* text) { return length(text) * 2; }\n"
+        )
+    );
+
+    auto library = builder.build();
+
+    ASSERT_TRUE(library->isLoaded()) << library->errorString();
+    ASSERT_EQ(library->resolveFunction<int(const char*)>("twice")("abc"), 6);
+
+    auto symbols = library->symbols();
+
+    ASSERT_NE(std::find(symbols.begin(), symbols.end(), "length"), symbols.end());
+
+    ASSERT_TRUE(library->unload());
+    ASSERT_TRUE(library->load()) << library->errorString();
+    ASSERT_EQ(library->resolveFunction<int(const char*)>("length")("abcd"), 4);
+
+    builder.clearTargets();
+
+    builder.addTarget(
+        CodeExecutor::Source::createFromSource(
+            "extern \"C\" int undefined_function();\n"
+            "extern \"C\" int call() { return undefined_function(); }\n"
+        )
+    );
+
+    auto broken = builder.build();
+
+    ASSERT_FALSE(broken->isLoaded());
+    ASSERT_NE(broken->errorString().find("undefined_function"), std::string::npos);
+
+    // Object without exported symbols
+    builder.clearTargets();
+
+    builder.addTarget(
+        CodeExecutor::Source::createFromSource(
+            "extern \"C\" int undefined_function();\n"
+            "__attribute__((used)) static int call() { return undefined_function(); }\n"
+        )
+    );
+
+    auto hidden = builder.build();
+
+    ASSERT_FALSE(hidden->isLoaded());
+    ASSERT_NE(hidden->errorString().find("undefined_function"), std::string::npos);
+
+    // Initializers run in linker order, object
+    // without exported symbols is initialized too
+    builder.clearTargets();
+
+    builder.addTarget(
+        CodeExecutor::Source::createFromSource(
+            "extern \"C\" { int events[8]; int count = 0; int* finalized = nullptr; }\n"
+            "extern \"C\" void record(int value) { events[count++] = value; }\n"
+            "extern \"C\" int event(int index) { return events[index]; }\n"
+            "__attribute__((constructor(200))) static void late() { record(2); }\n"
+            "__attribute__((constructor(101))) static void early() { record(1); }\n"
+            "static struct Init { Init() { record(3); } } init;\n"
+            "__attribute__((destructor)) static void finish() { *finalized = count; }\n"
+        )
+    );
+
+    builder.addTarget(
+        CodeExecutor::Source::createFromSource(
+            "extern \"C\" void record(int value);\n"
+            "static struct Other { Other() { record(4); } } other;\n"
+        )
+    );
+
+    auto constructed = builder.build();
+
+    ASSERT_TRUE(constructed->isLoaded()) << constructed->errorString();
+    ASSERT_EQ(*static_cast<int*>(constructed->resolve("count")), 4);
+
+    auto event = constructed->resolveFunction<int(int)>("event");
+
+    for (int i = 0; i < 4; ++i)
+    {
+        ASSERT_EQ(event(i), i + 1);
+    }
+
+    int finalized = 0;
+
+    *static_cast<int**>(constructed->resolve("finalized")) = &finalized;
+
+    ASSERT_TRUE(constructed->unload());
+    ASSERT_EQ(finalized, 4);
+
+    // Destructors of static objects are run
+    // by library, not at process exit
+    builder.clearTargets();
+
+    builder.addTarget(
+        CodeExecutor::Source::createFromSource(
+            "extern \"C\" { int* destroyed = nullptr; }\n"
+            "static struct Guard { ~Guard() { *destroyed = 9; } } guard;\n"
+        )
+    );
+
+    auto guarded = builder.build();
+
+    ASSERT_TRUE(guarded->isLoaded()) << guarded->errorString();
+
+    int destroyed = 0;
+
+    *static_cast<int**>(guarded->resolve("destroyed")) = &destroyed;
+
+    ASSERT_TRUE(guarded->unload()) << guarded->errorString();
+    ASSERT_EQ(destroyed, 9);
+}
+#endif
@@ -0,0 +1,376 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <csignal>
+#include <thread>
+#include <CodeExecutor/Process.hpp>
+#include <CodeExecutor/ProcessPool.hpp>
+#include <CodeExecutor/Builder.hpp>
+#include <CodeExecutor/CommonCompiler.hpp>
+#include <CodeExecutor/CommonLinker.hpp>
+
+TEST(Process, Start)
+{
+    CodeExecutor::Process process("/bin/cat");
+
+    process.setInputData("Input data");
+
+    ASSERT_EQ(process.start(), 0);
+
+    ASSERT_EQ(process.readStandardOutput(), "Input data");
+}
+
+TEST(Process, ExitCode)
+{
+    CodeExecutor::Process process("/bin/sh", {"-c", "echo error >&2; exit 3"});
+
+    ASSERT_EQ(process.start(), 3);
+
+    ASSERT_EQ(process.readStandardError(), "error\n");
+}
+
+TEST(Process, Signal)
+{
+    CodeExecutor::Process process("/bin/sh", {"-c", "kill -9 $$"});
+
+    ASSERT_EQ(process.start(), 128 + SIGKILL);
+
+    CodeExecutor::Process uringProcess("/bin/sh", {"-c", "kill -9 $$"});
+
+    uringProcess.setIoEngine(CodeExecutor::Process::IoEngine::Uring);
+
+    ASSERT_EQ(uringProcess.start(), 128 + SIGKILL);
+
+    auto server = CodeExecutor::ForkServer::create();
+
+    ASSERT_NE(server, nullptr);
+
+    CodeExecutor::Process serverProcess("/bin/sh", {"-c", "kill -9 $$"});
+
+    serverProcess.setForkServer(server);
+
+    ASSERT_EQ(serverProcess.start(), 128 + SIGKILL);
+}
+
+TEST(Process, NotFound)
+{
+    CodeExecutor::Process process("/nonexistent/program");
+
+    ASSERT_EQ(process.start(), 127);
+}
+
+TEST(Process, Concurrent)
+{
+    std::vector<std::thread> threads;
+    std::atomic_int succeeded{0};
+
+    for (int i = 0; i < 8; ++i)
+    {
+        threads.emplace_back([i, &succeeded]()
+        {
+            for (int j = 0; j < 16; ++j)
+            {
+                auto data = std::to_string(i) + ":" + std::to_string(j);
+
+                CodeExecutor::Process process("/bin/cat");
+
+                process.setInputData(data);
+
+                if (process.start() == 0 &&
+                    process.readStandardOutput() == data)
+                {
+                    ++succeeded;
+                }
+            }
+        });
+    }
+
+    for (auto&& thread : threads)
+    {
+        thread.join();
+    }
+
+    ASSERT_EQ(succeeded, 8 * 16);
+}
+
+TEST(Process, InputBuffer)
+{
+    auto buffer = std::make_shared<const std::string>(8 * 1024 * 1024, 'a');
+
+    CodeExecutor::Process process("/usr/bin/wc", {"-c"});
+
+    process.setInputBuffer(buffer);
+
+    ASSERT_EQ(process.inputBuffer().get(), buffer.get());
+
+    ASSERT_EQ(process.start(), 0);
+
+    ASSERT_EQ(process.readStandardOutput(), std::to_string(buffer->size()) + "\n");
+}
+
+TEST(Process, Uring)
+{
+    // Poll is used instead, if kernel
+    // has no io_uring
+    CodeExecutor::Process process(
+        "/bin/sh",
+        {"-c", "cat; head -c 200000 /dev/zero >&2; exit 5"}
+    );
+
+    process.setIoEngine(CodeExecutor::Process::IoEngine::Uring);
+    process.setInputData(std::string(300000, 'a'));
+
+    ASSERT_EQ(process.start(), 5);
+
+    ASSERT_EQ(process.readStandardOutput().size(), 300000);
+    ASSERT_EQ(process.readStandardError().size(), 200000);
+}
+
+TEST(Process, ResourceUsage)
+{
+    CodeExecutor::Process process(
+        "/bin/sh",
+        {"-c", "i=0; while [ $i -lt 20000 ]; do i=$((i+1)); done"}
+    );
+
+    ASSERT_EQ(process.start(), 0);
+
+    auto& usage = process.resourceUsage();
+
+    ASSERT_GT((usage.userTime + usage.systemTime).count(), 0);
+    ASSERT_GT(usage.maxResidentSetSize, 0);
+    ASSERT_GT(usage.minorPageFaults, 0);
+}
+
+TEST(Process, ControlGroup)
+{
+    auto parent = CodeExecutor::ControlGroup::current();
+
+    CodeExecutor::ControlGroupPtr group;
+
+    try
+    {
+        group = std::make_shared<CodeExecutor::ControlGroup>(
+            parent / "CodeExecutorTests"
+        );
+    }
+    catch (const std::runtime_error&)
+    {
+        GTEST_SKIP() << "cgroup v2 is not delegated";
+    }
+
+    CodeExecutor::Process process("/bin/cat", {"/proc/self/cgroup"});
+
+    process.setControlGroup(group);
+
+    ASSERT_EQ(process.start(), 0);
+
+    ASSERT_NE(process.readStandardOutput().find("/CodeExecutorTests"), std::string::npos);
+
+    auto server = CodeExecutor::ForkServer::create();
+
+    CodeExecutor::Process forked("/bin/cat", {"/proc/self/cgroup"});
+
+    forked.setControlGroup(group);
+    forked.setForkServer(server);
+
+    ASSERT_EQ(forked.start(), 0);
+
+    ASSERT_NE(forked.readStandardOutput().find("/CodeExecutorTests"), std::string::npos);
+    ASSERT_GT(forked.resourceUsage().maxResidentSetSize, 0);
+}
+
+TEST(Process, ForkServer)
+{
+    auto server = CodeExecutor::ForkServer::create();
+
+    ASSERT_NE(server, nullptr);
+    ASSERT_GT(server->pid(), 0);
+
+    CodeExecutor::Process process("/bin/sh", {"-c", "cat; pwd; exit 4"});
+
+    process.setForkServer(server);
+    process.setWorkingDirectory("/");
+    process.setInputData("Input data\n");
+
+    ASSERT_EQ(process.start(), 4);
+
+    ASSERT_EQ(process.readStandardOutput(), "Input data\n/\n");
+
+    CodeExecutor::Process uringProcess("/bin/sh", {"-c", "cat; exit 6"});
+
+    uringProcess.setForkServer(server);
+    uringProcess.setIoEngine(CodeExecutor::Process::IoEngine::Uring);
+    uringProcess.setInputData("Input data\n");
+
+    ASSERT_EQ(uringProcess.start(), 6);
+
+    ASSERT_EQ(uringProcess.readStandardOutput(), "Input data\n");
+}
+
+TEST(Process, ForkServerBuilding)
+{
+    CodeExecutor::ForkServer::setGlobal(CodeExecutor::ForkServer::create());
+
+    CodeExecutor::Builder builder;
+
+    builder.setCompiler(
+        std::make_shared<CodeExecutor::CommonCompiler>(
+            "/usr/bin/gcc"
+        )
+    );
+
+    builder.setLinker(
+        std::make_shared<CodeExecutor::CommonLinker>(
+            "/usr/bin/gcc"
+        )
+    );
+
+    builder.setJobs(2);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        builder.addTarget(
+            CodeExecutor::Source::createFromSource(
+                "extern \"C\" int function" + std::to_string(i) + "(int number)"
+                "{ return number + " + std::to_string(i) + "; }"
+            )
+        );
+    }
+
+    CodeExecutor::LibraryPtr library;
+
+    ASSERT_NO_THROW(
+        library = builder.build()
+    );
+
+    CodeExecutor::ForkServer::setGlobal(nullptr);
+
+    auto function = library->resolveFunction<int(int)>("function3");
+
+    ASSERT_NE(function, nullptr);
+
+    ASSERT_EQ(function(12), 15);
+}
+
+TEST(Process, LargeOutput)
+{
+    // Output is larger, than pipe buffer, and
+    // input is read after output is written
+    CodeExecutor::Process process(
+        "/bin/sh",
+        {"-c", "head -c 1000000 /dev/zero; head -c 300000 /dev/zero >&2; cat"}
+    );
+
+    std::string input(500000, 'a');
+
+    std::size_t streamed = 0;
+
+    process.setInputData(input);
+    process.setCaptureLimit(400000);
+    process.setStandardOutputCallback([&streamed](const char*, std::size_t size)
+    {
+        streamed += size;
+    });
+
+    ASSERT_EQ(process.start(), 0);
+
+    ASSERT_EQ(streamed, 1500000);
+    ASSERT_EQ(process.readStandardOutput().size(), 400000);
+    ASSERT_EQ(process.readStandardError().size(), 300000);
+}
+
+TEST(Process, UnreadInput)
+{
+    CodeExecutor::Process process("/bin/true");
+
+    process.setInputData(std::string(1000000, 'a'));
+
+    ASSERT_EQ(process.start(), 0);
+}
+
+TEST(Process, Pool)
+{
+    CodeExecutor::ProcessPool pool;
+
+    std::vector<CodeExecutor::ProcessPtr> processes;
+    std::vector<std::future<int>> results;
+
+    for (int i = 0; i < 32; ++i)
+    {
+        auto process = std::make_shared<CodeExecutor::Process>(
+            "/bin/sh",
+            CodeExecutor::Process::ArgumentsContainer{
+                "-c", "cat; echo error >&2; exit " + std::to_string(i % 4)
+            }
+        );
+
+        process->setInputData(std::to_string(i));
+
+        processes.push_back(process);
+        results.push_back(pool.launch(process));
+    }
+
+    for (int i = 0; i < 32; ++i)
+    {
+        ASSERT_EQ(results[i].get(), i % 4);
+        ASSERT_EQ(processes[i]->readStandardOutput(), std::to_string(i));
+        ASSERT_EQ(processes[i]->readStandardError(), "error\n");
+    }
+
+    ASSERT_EQ(pool.running(), 0);
+}
+
+TEST(Process, PoolCallback)
+{
+    std::promise<std::string> promise;
+
+    {
+        CodeExecutor::ProcessPool pool;
+
+        auto process = std::make_shared<CodeExecutor::Process>("/bin/cat");
+
+        process->setInputData(std::string(1000000, 'a'));
+
+        pool.launch(
+            process,
+            [&promise](const CodeExecutor::ProcessPtr& process)
+            {
+                promise.set_value(process->readStandardOutput());
+            }
+        );
+
+        pool.launch(
+            std::make_shared<CodeExecutor::Process>("/nonexistent/program"),
+            [](const CodeExecutor::ProcessPtr& process)
+            {
+                ASSERT_EQ(process->exitCode(), 127);
+            }
+        );
+
+        // Destructor waits for launched processes
+    }
+
+    ASSERT_EQ(promise.get_future().get().size(), 1000000);
+}
+
+TEST(Process, PoolClosedOutputs)
+{
+    CodeExecutor::ProcessPool pool;
+
+    // Child keeps running after closing it's
+    // outputs, pool must serve others meanwhile
+    auto detached = pool.launch(
+        std::make_shared<CodeExecutor::Process>(
+            "/bin/sh",
+            CodeExecutor::Process::ArgumentsContainer{"-c", "exec >&- 2>&-; sleep 1; exit 3"}
+        )
+    );
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    auto quick = pool.launch(std::make_shared<CodeExecutor::Process>("/bin/true"));
+
+    ASSERT_EQ(quick.wait_for(std::chrono::milliseconds(500)), std::future_status::ready);
+    ASSERT_EQ(quick.get(), 0);
+    ASSERT_EQ(detached.get(), 3);
+}
@@ -0,0 +1,261 @@
+#include <gtest/gtest.h>
+#include <fstream>
+#include <unistd.h>
+#include <CodeExecutor/BuildService.hpp>
+#include <CodeExecutor/CommonCompiler.hpp>
+#include <CodeExecutor/CommonLinker.hpp>
+
+static CodeExecutor::BuilderPtr makeBuilder(const std::string& source)
+{
+    // Linker is shared, so library names are unique
+    static auto linker = std::make_shared<CodeExecutor::CommonLinker>(
+        "/usr/bin/gcc"
+    );
+
+    auto builder = std::make_shared<CodeExecutor::Builder>();
+
+    builder->setCompiler(
+        std::make_shared<CodeExecutor::CommonCompiler>(
+            "/usr/bin/gcc"
+        )
+    );
+
+    builder->setLinker(linker);
+
+    builder->setJobs(1);
+
+    builder->addTarget(
+        CodeExecutor::Source::createFromSource(source)
+    );
+
+    return builder;
+}
+
+TEST(Service, Builds)
+{
+    CodeExecutor::BuildService service(2);
+
+    ASSERT_EQ(service.concurrency(), 2);
+
+    std::vector<std::future<CodeExecutor::LibraryPtr>> futures;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        futures.push_back(
+            service.submit(
+                makeBuilder(
+                    "extern \"C\" int function(int number)"
+                    "{ return number + " + std::to_string(i) + "; }"
+                ),
+                i
+            )
+        );
+    }
+
+    for (int i = 0; i < 4; ++i)
+    {
+        CodeExecutor::LibraryPtr library;
+
+        ASSERT_NO_THROW(
+            library = futures[i].get()
+        );
+
+        auto function = library->resolveFunction<int(int)>("function");
+
+        ASSERT_NE(function, nullptr);
+
+        ASSERT_EQ(function(12), 12 + i);
+    }
+}
+
+TEST(Service, History)
+{
+    CodeExecutor::BuildService service(1);
+
+    auto builder = makeBuilder(
+        "extern \"C\" int function(int number)"
+        "{ return number; }"
+    );
+
+    ASSERT_EQ(
+        service.expectedDuration(builder->fingerprint()),
+        CodeExecutor::BuildService::Clock::duration::zero()
+    );
+
+    ASSERT_NO_THROW(
+        service.submit(builder).get()
+    );
+
+    ASSERT_GT(
+        service.expectedDuration(builder->fingerprint()),
+        CodeExecutor::BuildService::Clock::duration::zero()
+    );
+}
+
+TEST(Service, Deadline)
+{
+    CodeExecutor::BuildService service(1);
+
+    auto future = service.submit(
+        makeBuilder(
+            "extern \"C\" int function(int number)"
+            "{ return number; }"
+        ),
+        0,
+        CodeExecutor::BuildService::Clock::now() - std::chrono::seconds(1)
+    );
+
+    ASSERT_THROW(
+        future.get(),
+        std::runtime_error
+    );
+}
+
+TEST(Service, QueuedDeadline)
+{
+    CodeExecutor::BuildService service(1);
+
+    // Keeps the only worker busy
+    auto slow = service.submit(
+        makeBuilder(
+            "#include <regex>\n"
+            "extern \"C\" int function(int number)"
+            "{ return std::regex_match(\"a\", std::regex(\"a+\")) + number; }"
+        )
+    );
+
+    auto queued = service.submit(
+        makeBuilder(
+            "extern \"C\" int function(int number)"
+            "{ return number; }"
+        ),
+        0,
+        CodeExecutor::BuildService::Clock::now() + std::chrono::milliseconds(10)
+    );
+
+    ASSERT_THROW(
+        queued.get(),
+        std::runtime_error
+    );
+
+    // Queued job failed without waiting for running one
+    ASSERT_NE(
+        slow.wait_for(std::chrono::seconds(0)),
+        std::future_status::ready
+    );
+
+    ASSERT_NO_THROW(
+        slow.get()
+    );
+}
+
+TEST(Service, HistorySize)
+{
+    CodeExecutor::BuildService service(1, 512ull * 1024 * 1024, 1);
+
+    auto first = makeBuilder(
+        "extern \"C\" int function(int number)"
+        "{ return number; }"
+    );
+
+    auto second = makeBuilder(
+        "extern \"C\" int function(int number)"
+        "{ return number + 1; }"
+    );
+
+    ASSERT_NO_THROW(
+        service.submit(first).get()
+    );
+
+    ASSERT_NO_THROW(
+        service.submit(second).get()
+    );
+
+    ASSERT_EQ(service.historySize(), 1);
+
+    ASSERT_EQ(
+        service.expectedDuration(first->fingerprint()),
+        CodeExecutor::BuildService::Clock::duration::zero()
+    );
+
+    ASSERT_GT(
+        service.expectedDuration(second->fingerprint()),
+        CodeExecutor::BuildService::Clock::duration::zero()
+    );
+}
+
+TEST(Service, CompilerProcesses)
+{
+    auto directory = std::filesystem::temp_directory_path() /
+                     ("service_compiler_" + std::to_string(getpid()));
+
+    std::filesystem::create_directories(directory);
+
+    // Wrapper marks itself as running and records
+    // number of compilers, running at the moment
+    auto compiler = directory / "compiler.sh";
+    auto marks = (directory / "running.").string();
+    auto counts = (directory / "counts").string();
+
+    std::ofstream(compiler.string())
+        << "#!/bin/sh\n"
+        << "mkdir \"" << marks << "$$\"\n"
+        << "ls -d \"" << marks << "\"* | wc -l >> \"" << counts << "\"\n"
+        << "/usr/bin/gcc \"$@\"\n"
+        << "status=$?\n"
+        << "rmdir \"" << marks << "$$\"\n"
+        << "exit $status\n";
+
+    std::filesystem::permissions(compiler, std::filesystem::perms::owner_all);
+
+    {
+        CodeExecutor::BuildService service(2);
+
+        std::vector<std::future<CodeExecutor::LibraryPtr>> futures;
+
+        for (int i = 0; i < 4; ++i)
+        {
+            auto builder = makeBuilder(
+                "extern \"C\" int function(int number)"
+                "{ return number + " + std::to_string(i) + "; }"
+            );
+
+            builder->setCompiler(std::make_shared<CodeExecutor::CommonCompiler>(compiler));
+            builder->setJobs(4);
+
+            for (int j = 0; j < 3; ++j)
+            {
+                builder->addTarget(
+                    CodeExecutor::Source::createFromSource(
+                        "extern \"C\" int function" + std::to_string(j) + "() { return " +
+                        std::to_string(i) + "; }"
+                    )
+                );
+            }
+
+            futures.push_back(service.submit(builder));
+        }
+
+        for (auto&& future : futures)
+        {
+            ASSERT_NO_THROW(
+                future.get()
+            );
+        }
+    }
+
+    std::ifstream stream(counts);
+
+    int count = 0;
+    int maximum = 0;
+
+    while (stream >> count)
+    {
+        maximum = std::max(maximum, count);
+    }
+
+    std::filesystem::remove_all(directory);
+
+    ASSERT_GE(maximum, 1);
+    ASSERT_LE(maximum, 2);
+}